@@ -0,0 +1,357 @@
+#include "cameracalib/boardTracker.hpp"
+#include "cameracalib/calibration.hpp"
+#include "cameracalib/detection.hpp"
+#include "cameracalib/prefilter.hpp"
+#include "cameracalib/profiler.hpp"
+#include "cameracalib/synthetic.hpp"
+#include "cameracalib/threadPool.hpp"
+#include "cameracalib/tiledRemap.hpp"
+#include "cameracalib/undistortion.hpp"
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cameracalib;
+
+struct BenchmarkResult {
+    std::string name;
+    cv::Size imageSize;
+    cv::Size checkerboardSize;
+    int views = 0;
+    TimingStats stats;
+};
+
+// Silences std::cout while library functions that report progress are being timed
+class QuietOutput {
+public:
+    QuietOutput() : saved_(std::cout.rdbuf(sink_.rdbuf())) {}
+    ~QuietOutput() { std::cout.rdbuf(saved_); }
+
+private:
+    std::ostringstream sink_;
+    std::streambuf* saved_;
+};
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [options]\n";
+    std::cout << "Options:\n";
+    std::cout << "  --sizes <WxH,...>            Image resolutions to benchmark (default: 1280x960,4000x3000)\n";
+    std::cout << "  --boards <WxH,...>           Board sizes in inner corners (default: 7x10)\n";
+    std::cout << "  --views <n,...>              View counts for the calibrate and reprojection benchmarks (default: 5,10,20,40)\n";
+    std::cout << "  -r, --repetitions <n>        Timed runs per benchmark after one warm-up run (default: 10)\n";
+    std::cout << "  --filter <text>              Only run benchmarks whose name contains text\n";
+    std::cout << "  -o, --output <file>          Write the results to this JSON file\n";
+    std::cout << "  -h, --help                   Show this help message\n";
+}
+
+std::vector<cv::Size> parseSizes(const std::string& text) {
+    std::vector<cv::Size> sizes;
+    std::stringstream stream(text);
+    std::string size;
+    while (std::getline(stream, size, ',')) {
+        size_t x = size.find('x');
+        if (x == std::string::npos) {
+            throw std::invalid_argument("expected <w>x<h>");
+        }
+        sizes.push_back(cv::Size(std::stoi(size.substr(0, x)), std::stoi(size.substr(x + 1))));
+    }
+    return sizes;
+}
+
+// Runs body once to warm caches and lazy initialization, then times it repetitions times
+TimingStats measure(int repetitions, const std::function<void()>& body) {
+    body();
+    std::vector<double> samples;
+    for (int i = 0; i < repetitions; i++) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        samples.push_back(elapsed.count());
+    }
+    return computeTimingStats(samples);
+}
+
+bool saveBenchmarkJSON(const std::vector<BenchmarkResult>& results, int repetitions, const std::string& outputFile) {
+    std::ofstream file(outputFile);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write to benchmark file " << outputFile << std::endl;
+        return false;
+    }
+
+    file << std::setprecision(9);
+    file << "{\n";
+    file << "  \"opencv_version\": \"" << CV_VERSION << "\",\n";
+    file << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    file << "  \"repetitions\": " << repetitions << ",\n";
+    file << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& result = results[i];
+        const TimingStats& stats = result.stats;
+        file << "    {\"name\": \"" << result.name << "\", "
+             << "\"image_dimensions_wh\": [" << result.imageSize.width << ", " << result.imageSize.height << "], "
+             << "\"checkerboard_dimensions_wh\": [" << result.checkerboardSize.width << ", " << result.checkerboardSize.height << "], "
+             << "\"views\": " << result.views << ", "
+             << "\"count\": " << stats.count << ", \"min_ms\": " << stats.minMs << ", \"mean_ms\": " << stats.meanMs
+             << ", \"p50_ms\": " << stats.p50Ms << ", \"p95_ms\": " << stats.p95Ms << ", \"max_ms\": " << stats.maxMs << "}";
+        if (i < results.size() - 1) file << ",";
+        file << "\n";
+    }
+    file << "  ]\n";
+    file << "}\n";
+
+    std::cout << "\nBenchmark results saved to: " << outputFile << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<cv::Size> imageSizes = {cv::Size(1280, 960), cv::Size(4000, 3000)};
+    std::vector<cv::Size> boardSizes = {cv::Size(7, 10)};
+    std::vector<int> viewCounts = {5, 10, 20, 40};
+    int repetitions = 10;
+    std::string filter;
+    std::string outputFile;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        try {
+            if (arg == "-h" || arg == "--help") {
+                printUsage(argv[0]);
+                return 0;
+            } else if (arg == "--sizes" && i + 1 < argc) {
+                imageSizes = parseSizes(argv[++i]);
+            } else if (arg == "--boards" && i + 1 < argc) {
+                boardSizes = parseSizes(argv[++i]);
+            } else if (arg == "--views" && i + 1 < argc) {
+                viewCounts.clear();
+                std::stringstream views(argv[++i]);
+                std::string count;
+                while (std::getline(views, count, ',')) {
+                    viewCounts.push_back(std::stoi(count));
+                }
+            } else if ((arg == "-r" || arg == "--repetitions") && i + 1 < argc) {
+                repetitions = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--filter" && i + 1 < argc) {
+                filter = argv[++i];
+            } else if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+                outputFile = argv[++i];
+            } else {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid value for " << arg << ": " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (viewCounts.empty() || *std::min_element(viewCounts.begin(), viewCounts.end()) < 3) {
+        std::cerr << "Error: Every view count must be at least 3." << std::endl;
+        return 1;
+    }
+    int maxViews = *std::max_element(viewCounts.begin(), viewCounts.end());
+
+    ThreadPool pool(std::max(1, cv::getNumThreads()));
+    std::vector<BenchmarkResult> results;
+    auto run = [&](const std::string& name, const cv::Size& imageSize, const cv::Size& board, int views,
+                   const std::function<void()>& body) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) {
+            return;
+        }
+        BenchmarkResult result;
+        result.name = name;
+        result.imageSize = imageSize;
+        result.checkerboardSize = board;
+        result.views = views;
+        result.stats = measure(repetitions, body);
+        results.push_back(result);
+
+        std::cout << "  " << std::left << std::setw(20) << name << std::right << std::setw(6) << views << " views"
+                  << std::fixed << std::setprecision(3) << std::setw(12) << result.stats.meanMs << " ms mean"
+                  << std::setw(12) << result.stats.p50Ms << " ms p50" << std::setw(12) << result.stats.p95Ms << " ms p95"
+                  << std::defaultfloat << std::setprecision(6) << std::endl;
+    };
+
+    std::string jsonFile = (std::filesystem::temp_directory_path() / "cameracalib_benchmark.json").string();
+
+    for (const cv::Size& imageSize : imageSizes) {
+        for (const cv::Size& board : boardSizes) {
+            std::cout << "\n" << imageSize.width << "x" << imageSize.height << " image, " << board.width << "x" << board.height
+                      << " board:" << std::endl;
+
+            // Synthetic input with a moderately distorting lens and known corners
+            SyntheticOptions synthetic;
+            synthetic.imageSize = imageSize;
+            synthetic.checkerboardSize = board;
+            synthetic.distortion = {-0.12, 0.03, 0.0, 0.0, 0.0};
+            synthetic.numViews = maxViews;
+            std::vector<SyntheticView> views;
+            if (!generateSyntheticPoses(synthetic, views)) {
+                return 1;
+            }
+            renderSyntheticView(synthetic, 0, views[0]);
+
+            cv::Mat frame;
+            cv::cvtColor(views[0].image, frame, cv::COLOR_GRAY2BGR);
+            std::vector<uchar> encoded;
+            cv::imencode(".jpg", frame, encoded);
+            cv::Mat gray = views[0].image;
+
+            run("decode_gray", imageSize, board, 1, [&]() {
+                cv::Mat decoded = cv::imdecode(encoded, cv::IMREAD_COLOR);
+                cv::Mat decodedGray;
+                cv::cvtColor(decoded, decodedGray, cv::COLOR_BGR2GRAY);
+            });
+
+            run("find_corners_hit", imageSize, board, 1, [&]() {
+                std::vector<cv::Point2f> corners;
+                findCheckerboardCorners(gray, board, corners);
+            });
+
+            run("find_corners_sb_hit", imageSize, board, 1, [&]() {
+                std::vector<cv::Point2f> corners;
+                findCheckerboardCorners(gray, board, corners, nullptr, DetectorBackend::SectorBased);
+            });
+
+            // Searching for a board with one more column never succeeds and runs the full search
+            run("find_corners_miss", imageSize, board, 1, [&]() {
+                std::vector<cv::Point2f> corners;
+                findCheckerboardCorners(gray, cv::Size(board.width + 1, board.height), corners);
+            });
+
+            run("corner_subpix", imageSize, board, 1, [&]() {
+                std::vector<cv::Point2f> corners = views[0].corners;
+                refineCheckerboardCorners(gray, corners);
+            });
+
+            run("prefilter", imageSize, board, 1, [&]() {
+                computePrefilterScores(gray, PrefilterOptions());
+            });
+
+            // Full detection against tracked detection primed with the board's position, as for
+            // the next frame of a video where the board barely moved
+            DetectionOptions detection;
+            run("detect_full", imageSize, board, 1, [&]() {
+                detectCheckerboardInGray(gray, board, detection);
+            });
+
+            BoardTracker tracker;
+            tracker.detect(gray, board, detection);
+            run("detect_tracked", imageSize, board, 1, [&]() {
+                tracker.detect(gray, board, detection);
+            });
+
+            // Exact corners with 0.1 px detection noise for the solve benchmarks
+            CornerSet allCorners;
+            allCorners.imageSize = imageSize;
+            allCorners.checkerboardSize = board;
+            cv::RNG rng(synthetic.seed);
+            for (const SyntheticView& view : views) {
+                std::vector<cv::Point2f> noisy = view.corners;
+                for (cv::Point2f& p : noisy) {
+                    p.x += static_cast<float>(rng.gaussian(0.1));
+                    p.y += static_cast<float>(rng.gaussian(0.1));
+                }
+                allCorners.imgpoints.push_back(noisy);
+            }
+
+            // Ground truth stands in until (or if) the solve benchmark produces a calibration
+            CalibrationResults calibrated = syntheticGroundTruth(synthetic, views);
+            for (int count : viewCounts) {
+                CornerSet corners = allCorners;
+                corners.imgpoints.resize(count);
+                run("calibrate_camera", imageSize, board, count, [&]() {
+                    QuietOutput quiet;
+                    CalibrationResults solved = solveCalibration(corners);
+                    if (solved.success) {
+                        calibrated = solved;
+                    }
+                });
+                run("reprojection", imageSize, board, count, [&]() {
+                    meanReprojectionError(corners, calibrated);
+                });
+            }
+
+            run("save_json", imageSize, board, calibrated.numImagesUsed, [&]() {
+                QuietOutput quiet;
+                saveCalibrationResultsToJSON(calibrated, jsonFile);
+            });
+
+            run("undistort", imageSize, board, 1, [&]() {
+                cv::Mat undistorted;
+                undistortImage(calibrated, frame, undistorted);
+            });
+
+            UndistortMaps maps;
+            run("undistort_maps", imageSize, board, 1, [&]() {
+                buildUndistortMaps(calibrated, imageSize, maps);
+            });
+
+            run("undistort_remap", imageSize, board, 1, [&]() {
+                cv::Mat undistorted;
+                remapImage(maps, frame, undistorted);
+            });
+
+            UndistortMaps fixedMaps;
+            buildUndistortMaps(calibrated, imageSize, fixedMaps, UndistortMapFormat::Fixed);
+            run("undistort_remap_fixed", imageSize, board, 1, [&]() {
+                cv::Mat undistorted;
+                remapImage(fixedMaps, frame, undistorted);
+            });
+
+            // The tiled kernel gets as many threads as cv::remap uses internally
+            run("undistort_tiled", imageSize, board, 1, [&]() {
+                cv::Mat undistorted;
+                remapTiled(maps, frame, undistorted, &pool);
+            });
+
+            run("undistort_tiled_fixed", imageSize, board, 1, [&]() {
+                cv::Mat undistorted;
+                remapTiled(fixedMaps, frame, undistorted, &pool);
+            });
+
+            UndistortMaps gridMaps;
+            run("undistort_maps_grid", imageSize, board, 1, [&]() {
+                buildUndistortMaps(calibrated, imageSize, gridMaps, UndistortMapFormat::Grid);
+            });
+
+            run("undistort_remap_grid", imageSize, board, 1, [&]() {
+                cv::Mat undistorted;
+                remapImage(gridMaps, frame, undistorted);
+            });
+
+            run("undistort_tiled_grid", imageSize, board, 1, [&]() {
+                cv::Mat undistorted;
+                remapTiled(gridMaps, frame, undistorted, &pool);
+            });
+
+            run("undistort_remap_gray", imageSize, board, 1, [&]() {
+                cv::Mat undistorted;
+                remapImage(fixedMaps, gray, undistorted);
+            });
+
+            run("undistort_tiled_gray", imageSize, board, 1, [&]() {
+                cv::Mat undistorted;
+                remapTiled(fixedMaps, gray, undistorted, &pool);
+            });
+        }
+    }
+    std::filesystem::remove(jsonFile);
+
+    if (!outputFile.empty() && !saveBenchmarkJSON(results, repetitions, outputFile)) {
+        return 1;
+    }
+    return 0;
+}
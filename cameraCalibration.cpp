@@ -1,216 +1,79 @@
+#include "cameracalib/calibration.hpp"
+#include "cameracalib/calibrationBundle.hpp"
+#include "cameracalib/commandLine.hpp"
+#include "cameracalib/cornerFile.hpp"
+#include "cameracalib/engine.hpp"
+#include "cameracalib/profiler.hpp"
+
 #include <opencv2/opencv.hpp>
-#include <opencv2/calib3d/calib3d.hpp>
-#include <opencv2/highgui/highgui.hpp>
-#include <opencv2/imgproc/imgproc.hpp>
-#include <stdio.h>
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <vector>
 #include <filesystem>
+#include <memory>
+#include <stdexcept>
 
-struct CalibrationResults {
-    cv::Mat cameraMatrix;
-    cv::Mat distCoeffs;
-    std::vector<cv::Mat> rvecs;
-    std::vector<cv::Mat> tvecs;
-    bool success;
-    cv::Size imageSize;
-    cv::Size checkerboardSize;
-    int numImagesUsed;
-    double meanReprojectionError;
-};
+using namespace cameracalib;
 
-void saveCalibrationResultsToJSON(const CalibrationResults& results, const std::string& outputFile) {
-    std::ofstream file(outputFile);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not write to output file " << outputFile << std::endl;
-        return;
-    }
-
-    file << "{\n";
-    file << "  \"camera_matrix\": [\n";
-    for (int i = 0; i < 3; i++) {
-        file << "    [";
-        for (int j = 0; j < 3; j++) {
-            file << results.cameraMatrix.at<double>(i, j);
-            if (j < 2) file << ", ";
-        }
-        file << "]";
-        if (i < 2) file << ",";
-        file << "\n";
-    }
-    file << "  ],\n";
-    
-    file << "  \"distortion_coefficients\": [";
-    for (int i = 0; i < results.distCoeffs.rows; i++) {
-        file << results.distCoeffs.at<double>(i, 0);
-        if (i < results.distCoeffs.rows - 1) file << ", ";
-    }
-    file << "],\n";
-    
-    file << "  \"rotation_vectors\": [\n";
-    for (size_t i = 0; i < results.rvecs.size(); i++) {
-        file << "    [";
-        for (int j = 0; j < 3; j++) {
-            file << results.rvecs[i].at<double>(j, 0);
-            if (j < 2) file << ", ";
-        }
-        file << "]";
-        if (i < results.rvecs.size() - 1) file << ",";
-        file << "\n";
-    }
-    file << "  ],\n";
-    
-    file << "  \"translation_vectors\": [\n";
-    for (size_t i = 0; i < results.tvecs.size(); i++) {
-        file << "    [";
-        for (int j = 0; j < 3; j++) {
-            file << results.tvecs[i].at<double>(j, 0);
-            if (j < 2) file << ", ";
+// Prints the collected stage timings and writes them to profileOut, if profiling was requested
+int finishProfile(const Profiler* profiler, const std::string& profileOut, int status) {
+    if (profiler) {
+        profiler->print(std::cout);
+        if (!profiler->saveJSON(profileOut)) {
+            return 1;
         }
-        file << "]";
-        if (i < results.tvecs.size() - 1) file << ",";
-        file << "\n";
     }
-    file << "  ],\n";
-    
-    file << "  \"calibration_success\": " << (results.success ? "true" : "false") << ",\n";
-    file << "  \"image_dimensions_wh\": [" << results.imageSize.width << ", " << results.imageSize.height << "],\n";
-    file << "  \"checkerboard_dimensions_wh\": [" << results.checkerboardSize.width << ", " << results.checkerboardSize.height << "],\n";
-    file << "  \"num_images_used\": " << results.numImagesUsed << ",\n";
-    file << "  \"mean_reprojection_error\": " << results.meanReprojectionError << "\n";
-    file << "}\n";
-    
-    file.close();
-    std::cout << "\nCalibration results successfully saved to: " << outputFile << std::endl;
+    return status;
 }
 
-CalibrationResults calibrateCamera(const std::string& imageDir, const cv::Size& checkerboardSize) {
-    std::cout << "Starting camera calibration..." << std::endl;
-    std::cout << "Image directory: " << imageDir << std::endl;
-    std::cout << "Checkerboard size: " << checkerboardSize.width << "x" << checkerboardSize.height << std::endl;
-
-    CalibrationResults results;
-    results.checkerboardSize = checkerboardSize;
-    results.success = false;
-    results.numImagesUsed = 0;
-    results.meanReprojectionError = 0.0;
-
-    // Creating vector to store vectors of 3D points for each checkerboard image
-    std::vector<std::vector<cv::Point3f>> objpoints;
-    // Creating vector to store vectors of 2D points for each checkerboard image
-    std::vector<std::vector<cv::Point2f>> imgpoints;
-
-    // Defining the world coordinates for 3D points
-    std::vector<cv::Point3f> objp;
-    for (int i = 0; i < checkerboardSize.height; i++) {
-        for (int j = 0; j < checkerboardSize.width; j++) {
-            objp.push_back(cv::Point3f(j, i, 0));
+// Writes the JSON and/or the binary bundle, whichever has a file name
+bool saveResults(const CalibrationResults& results, const std::string& jsonFile, const std::string& bundleFile,
+                 Profiler* profiler) {
+    if (!jsonFile.empty()) {
+        ScopedTimer timer(profiler, "write_json");
+        if (!saveCalibrationResultsToJSON(results, jsonFile)) {
+            return false;
         }
     }
-
-    // Extracting path of individual image stored in a given directory
-    std::vector<cv::String> images;
-    std::vector<std::string> patterns = {"*.jpg", "*.jpeg", "*.png", "*.bmp", "*.tiff"};
-    
-    for (const auto& pattern : patterns) {
-        std::vector<cv::String> temp;
-        cv::glob(imageDir + "/" + pattern, temp);
-        images.insert(images.end(), temp.begin(), temp.end());
-    }
-
-    if (images.empty()) {
-        std::cerr << "Error: No images found in directory '" << imageDir << "' with supported patterns." << std::endl;
-        return results;
-    }
-
-    std::cout << "Found " << images.size() << " images." << std::endl;
-
-    cv::Mat frame, gray;
-    std::vector<cv::Point2f> corner_pts;
-    bool success;
-    cv::Size imageSize;
-    bool imageSizeSet = false;
-
-    // Looping over all the images in the directory
-    for (size_t i = 0; i < images.size(); i++) {
-        std::cout << "Processing image " << (i + 1) << "/" << images.size() << ": " 
-                  << std::filesystem::path(images[i]).filename() << "..." << std::endl;
-        
-        frame = cv::imread(images[i]);
-        if (frame.empty()) {
-            std::cout << "Warning: Could not read image " << images[i] << ". Skipping." << std::endl;
-            continue;
-        }
-
-        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
-
-        if (!imageSizeSet) {
-            imageSize = cv::Size(gray.cols, gray.rows);
-            imageSizeSet = true;
-        }
-
-        // Finding checker board corners
-        success = cv::findChessboardCorners(gray, checkerboardSize, corner_pts, 
-                                          cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_FAST_CHECK | cv::CALIB_CB_NORMALIZE_IMAGE);
-
-        if (success) {
-            cv::TermCriteria criteria(cv::TermCriteria::EPS | cv::TermCriteria::MAX_ITER, 30, 0.001);
-            cv::cornerSubPix(gray, corner_pts, cv::Size(11, 11), cv::Size(-1, -1), criteria);
-
-            objpoints.push_back(objp);
-            imgpoints.push_back(corner_pts);
-            
-            std::cout << "  -> Checkerboard found and corners refined for " 
-                      << std::filesystem::path(images[i]).filename() << std::endl;
-        } else {
-            std::cout << "  -> Checkerboard not found in " 
-                      << std::filesystem::path(images[i]).filename() << std::endl;
-        }
+    if (!bundleFile.empty()) {
+        ScopedTimer timer(profiler, "write_bundle");
+        return saveCalibrationBundle(results, nullptr, bundleFile);
     }
+    return true;
+}
 
-    if (objpoints.empty() || imgpoints.empty()) {
-        std::cerr << "Error: No checkerboard corners were detected in any of the images. Calibration cannot proceed." << std::endl;
-        return results;
+// Loads a previous result from a JSON file or a calibration bundle
+bool loadPreviousResults(const std::string& file, CalibrationResults& results) {
+    if (isCalibrationBundle(file)) {
+        return loadCalibrationBundle(file, results);
     }
+    return loadCalibrationResultsFromJSON(file, results);
+}
 
-    if (!imageSizeSet) {
-        std::cerr << "Error: Could not determine image dimensions for calibration." << std::endl;
-        return results;
+// A seed from another board would start the optimizer from the wrong camera
+bool checkPreviousBoard(const CalibrationResults& previous, const std::string& previousFile, const cv::Size& checkerboardSize) {
+    if (previous.checkerboardSize == checkerboardSize) {
+        return true;
     }
+    std::cerr << "Error: " << previousFile << " was calibrated with a " << previous.checkerboardSize.width << "x"
+              << previous.checkerboardSize.height << " checkerboard, this run uses " << checkerboardSize.width << "x"
+              << checkerboardSize.height << "." << std::endl;
+    return false;
+}
 
-    std::cout << "\nPerforming camera calibration with " << objpoints.size() << " image(s) where corners were found..." << std::endl;
-
-    results.success = cv::calibrateCamera(objpoints, imgpoints, imageSize, 
-                                        results.cameraMatrix, results.distCoeffs, 
-                                        results.rvecs, results.tvecs);
-
+// Compares an incremental result with the one it was seeded from
+void printIncrementalSummary(const CalibrationResults& previous, const CalibrationResults& results) {
     if (!results.success) {
-        std::cerr << "Error: Camera calibration failed." << std::endl;
-        return results;
+        return;
     }
-
-    results.imageSize = imageSize;
-    results.numImagesUsed = objpoints.size();
-
-    std::cout << "\nCalibration successful!" << std::endl;
-    std::cout << "Camera matrix:" << std::endl << results.cameraMatrix << std::endl;
-    std::cout << "\nDistortion coefficients:" << std::endl << results.distCoeffs << std::endl;
-
-    // Calculate mean reprojection error
-    double totalError = 0.0;
-    for (size_t i = 0; i < objpoints.size(); i++) {
-        std::vector<cv::Point2f> imgpoints2;
-        cv::projectPoints(objpoints[i], results.rvecs[i], results.tvecs[i], 
-                         results.cameraMatrix, results.distCoeffs, imgpoints2);
-        double error = cv::norm(imgpoints[i], imgpoints2, cv::NORM_L2) / imgpoints2.size();
-        totalError += error;
+    if (previous.imageSize != results.imageSize) {
+        std::cout << "Incremental calibration: the previous result is for " << previous.imageSize.width << "x"
+                  << previous.imageSize.height << " images, these are " << results.imageSize.width << "x"
+                  << results.imageSize.height << "; it was not used as a seed." << std::endl;
     }
-    results.meanReprojectionError = totalError / objpoints.size();
-    std::cout << "\nTotal (Mean) Reprojection Error: " << results.meanReprojectionError << std::endl;
-
-    return results;
+    std::cout << "Incremental calibration: " << previous.numImagesUsed << " -> " << results.numImagesUsed
+              << " view(s), mean reprojection error " << previous.meanReprojectionError << " -> "
+              << results.meanReprojectionError << std::endl;
 }
 
 void printUsage(const char* programName) {
@@ -220,6 +83,19 @@ void printUsage(const char* programName) {
     std::cout << "  -o, --output_file <file>     Path to output JSON file (default: calibration_results.json)\n";
     std::cout << "  -cw, --checkerboard_width <width>   Number of inner corners along width (default: 7)\n";
     std::cout << "  -ch, --checkerboard_height <height> Number of inner corners along height (default: 10)\n";
+    printDetectionUsage();
+    std::cout << "  --profile-out <file>         Write per-stage timings (count, mean, p50, p95, max) to this JSON file\n";
+    std::cout << "  --bundle <file>              Also write the results as a memory-mappable binary bundle\n";
+    std::cout << "  --no-json                    Do not write the JSON output (use with --bundle)\n";
+    std::cout << "  --incremental <file>         Seed the solve with a previous result (JSON or bundle); needs --corner-cache for images\n";
+    std::cout << "  --detect-only <file>         Only detect corners and write them to this corner file, no calibration\n";
+    std::cout << "  --shard <k/n>                Only process every n-th image starting at index k (with --detect-only)\n";
+    std::cout << "  --solve-from <file>          Calibrate from a corner file instead of images (repeatable to merge shards)\n";
+    std::cout << "  --video <file>               Calibrate from the keyframes of a video instead of an image directory\n";
+    std::cout << "  --frame-step <n>             Examine every n-th video frame (default: 3)\n";
+    std::cout << "  --min-sharpness <v>          Skip video frames whose Laplacian variance is below v, 0 = off (default: 100)\n";
+    std::cout << "  --min-difference <v>         Skip video frames within this mean gray-level difference of an accepted one, 0 = off (default: 6)\n";
+    std::cout << "  --max-frames <n>             Stop reading the video after n keyframes, 0 = unlimited (default: 0)\n";
     std::cout << "  -h, --help                   Show this help message\n";
 }
 
@@ -228,31 +104,148 @@ int main(int argc, char* argv[]) {
     std::string outputFile = "calibration_results.json";
     int checkerboardWidth = 7;
     int checkerboardHeight = 10;
+    DetectionOptions detectionOptions;
+    std::string profileOut;
+    std::string detectOnlyFile;
+    std::vector<std::string> solveFromFiles;
+    std::string bundleFile;
+    bool writeJson = true;
+    std::string previousFile;
+    std::string videoFile;
+    KeyframeOptions keyframeOptions;
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
         
-        if (arg == "-h" || arg == "--help") {
-            printUsage(argv[0]);
-            return 0;
-        } else if ((arg == "-i" || arg == "--image_dir") && i + 1 < argc) {
-            imageDir = argv[++i];
-        } else if ((arg == "-o" || arg == "--output_file") && i + 1 < argc) {
-            outputFile = argv[++i];
-        } else if ((arg == "-cw" || arg == "--checkerboard_width") && i + 1 < argc) {
-            checkerboardWidth = std::stoi(argv[++i]);
-        } else if ((arg == "-ch" || arg == "--checkerboard_height") && i + 1 < argc) {
-            checkerboardHeight = std::stoi(argv[++i]);
-        } else {
-            std::cerr << "Unknown argument: " << arg << std::endl;
-            printUsage(argv[0]);
+        // Malformed values of any option end up in the catch below
+        try {
+            if (parseDetectionArgument(argc, argv, i, detectionOptions)) {
+                continue;
+            }
+
+            if (arg == "-h" || arg == "--help") {
+                printUsage(argv[0]);
+                return 0;
+            } else if ((arg == "-i" || arg == "--image_dir") && i + 1 < argc) {
+                imageDir = argv[++i];
+            } else if ((arg == "-o" || arg == "--output_file") && i + 1 < argc) {
+                outputFile = argv[++i];
+            } else if ((arg == "-cw" || arg == "--checkerboard_width") && i + 1 < argc) {
+                checkerboardWidth = std::stoi(argv[++i]);
+            } else if ((arg == "-ch" || arg == "--checkerboard_height") && i + 1 < argc) {
+                checkerboardHeight = std::stoi(argv[++i]);
+            } else if (arg == "--profile-out" && i + 1 < argc) {
+                profileOut = argv[++i];
+            } else if (arg == "--bundle" && i + 1 < argc) {
+                bundleFile = argv[++i];
+            } else if (arg == "--no-json") {
+                writeJson = false;
+            } else if (arg == "--incremental" && i + 1 < argc) {
+                previousFile = argv[++i];
+            } else if (arg == "--detect-only" && i + 1 < argc) {
+                detectOnlyFile = argv[++i];
+            } else if (arg == "--solve-from" && i + 1 < argc) {
+                solveFromFiles.push_back(argv[++i]);
+            } else if (arg == "--video" && i + 1 < argc) {
+                videoFile = argv[++i];
+            } else if (arg == "--frame-step" && i + 1 < argc) {
+                keyframeOptions.sampleStep = parseIntValue(argv[++i], 1);
+            } else if (arg == "--min-sharpness" && i + 1 < argc) {
+                keyframeOptions.minSharpness = parseDoubleValue(argv[++i], 0.0);
+            } else if (arg == "--min-difference" && i + 1 < argc) {
+                keyframeOptions.minDifference = parseDoubleValue(argv[++i], 0.0);
+            } else if (arg == "--max-frames" && i + 1 < argc) {
+                keyframeOptions.maxFrames = parseCountValue(argv[++i]);
+            } else if (arg == "--shard" && i + 1 < argc) {
+                std::string shard = argv[++i];
+                size_t slash = shard.find('/');
+                if (slash == std::string::npos) {
+                    throw std::invalid_argument("expected <k>/<n>, got '" + shard + "'");
+                }
+                detectionOptions.shardIndex = parseCountValue(shard.substr(0, slash));
+                detectionOptions.shardCount = parseCountValue(shard.substr(slash + 1), 1);
+                if (detectionOptions.shardIndex >= detectionOptions.shardCount) {
+                    throw std::invalid_argument("expected 0 <= k < n, got '" + shard + "'");
+                }
+            } else {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid value for " << arg << ": " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (!writeJson && bundleFile.empty()) {
+        std::cerr << "Error: --no-json needs --bundle, otherwise no results would be written." << std::endl;
+        return 1;
+    }
+    if (!detectOnlyFile.empty() && !solveFromFiles.empty()) {
+        std::cerr << "Error: --detect-only and --solve-from cannot be combined." << std::endl;
+        return 1;
+    }
+
+    if (!previousFile.empty() && !detectOnlyFile.empty()) {
+        std::cerr << "Error: --incremental and --detect-only cannot be combined." << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<Profiler> profiler;
+    if (!profileOut.empty()) {
+        profiler.reset(new Profiler());
+    }
+
+    // Incremental mode: start the solve from a previous result. Images already in the corner
+    // cache are not detected again, so only new files cost detection time.
+    CalibrationResults previous;
+    const CalibrationResults* initialGuess = nullptr;
+    if (!previousFile.empty()) {
+        ScopedTimer timer(profiler.get(), "load_previous");
+        if (!loadPreviousResults(previousFile, previous)) {
+            return 1;
+        }
+        if (solveFromFiles.empty() && !checkPreviousBoard(previous, previousFile, cv::Size(checkerboardWidth, checkerboardHeight))) {
+            return 1;
+        }
+        // Without the cache every image would be detected again, which is what incremental
+        // mode exists to avoid
+        if (detectionOptions.cornerCachePath.empty() && solveFromFiles.empty() && videoFile.empty()) {
+            std::cerr << "Error: --incremental needs --corner-cache <file> to skip the images detected before." << std::endl;
             return 1;
         }
+        initialGuess = &previous;
+        std::cout << "Incremental calibration from " << previousFile << " (" << previous.numImagesUsed
+                  << " view(s))" << std::endl;
+    }
+
+    // Solve-only mode: calibrate from corner files without reading any image
+    if (!solveFromFiles.empty()) {
+        CornerSet corners;
+        for (const std::string& cornerFile : solveFromFiles) {
+            ScopedTimer timer(profiler.get(), "load_corners");
+            if (!loadCornerFile(cornerFile, corners)) {
+                return 1;
+            }
+        }
+
+        // Corner files carry their own board size, which the seed has to match
+        if (initialGuess && !checkPreviousBoard(previous, previousFile, corners.checkerboardSize)) {
+            return 1;
+        }
+
+        CalibrationResults results = solveCalibration(corners, profiler.get(), initialGuess);
+        if (initialGuess) {
+            printIncrementalSummary(previous, results);
+        }
+        bool saved = results.success && saveResults(results, writeJson ? outputFile : std::string(), bundleFile, profiler.get());
+        return finishProfile(profiler.get(), profileOut, saved ? 0 : 1);
     }
 
     // Create image directory if it doesn't exist
-    if (!std::filesystem::exists(imageDir)) {
+    if (videoFile.empty() && !std::filesystem::exists(imageDir)) {
         try {
             std::filesystem::create_directories(imageDir);
             std::cout << "Created image directory: " << imageDir << std::endl;
@@ -265,11 +258,32 @@ int main(int argc, char* argv[]) {
     }
 
     cv::Size checkerboardSize(checkerboardWidth, checkerboardHeight);
-    CalibrationResults results = calibrateCamera(imageDir, checkerboardSize);
+    CalibrationEngine engine(detectionOptions);
+    engine.setProfiler(profiler.get());
+
+    // Detection-only mode: write the refined corners for a later --solve-from run
+    if (!detectOnlyFile.empty()) {
+        std::cout << "Starting corner detection..." << std::endl;
+        CornerSet corners;
+        bool detected = videoFile.empty() ? engine.detectCorners(imageDir, checkerboardSize, corners)
+                                          : engine.detectCornersInVideo(videoFile, checkerboardSize, keyframeOptions, corners);
+        if (!detected) {
+            return 1;
+        }
+        bool saved;
+        {
+            ScopedTimer timer(profiler.get(), "write_corners");
+            saved = saveCornerFile(corners, detectOnlyFile);
+        }
+        return finishProfile(profiler.get(), profileOut, saved ? 0 : 1);
+    }
 
-    if (results.success) {
-        saveCalibrationResultsToJSON(results, outputFile);
+    CalibrationResults results = videoFile.empty() ? engine.calibrate(imageDir, checkerboardSize, initialGuess)
+                                                   : engine.calibrateVideo(videoFile, checkerboardSize, keyframeOptions, initialGuess);
+    if (initialGuess) {
+        printIncrementalSummary(previous, results);
     }
 
-    return results.success ? 0 : 1;
+    bool saved = results.success && saveResults(results, writeJson ? outputFile : std::string(), bundleFile, profiler.get());
+    return finishProfile(profiler.get(), profileOut, saved ? 0 : 1);
 }
\ No newline at end of file
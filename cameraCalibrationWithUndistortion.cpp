@@ -1,233 +1,38 @@
+#include "cameracalib/calibration.hpp"
+#include "cameracalib/calibrationBundle.hpp"
+#include "cameracalib/commandLine.hpp"
+#include "cameracalib/detection.hpp"
+#include "cameracalib/engine.hpp"
+#include "cameracalib/profiler.hpp"
+
 #include <opencv2/opencv.hpp>
-#include <opencv2/calib3d/calib3d.hpp>
-#include <opencv2/highgui/highgui.hpp>
-#include <opencv2/imgproc/imgproc.hpp>
-#include <stdio.h>
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <vector>
 #include <filesystem>
+#include <memory>
 
-struct CalibrationResults {
-    cv::Mat cameraMatrix;
-    cv::Mat distCoeffs;
-    std::vector<cv::Mat> rvecs;
-    std::vector<cv::Mat> tvecs;
-    bool success;
-    cv::Size imageSize;
-    cv::Size checkerboardSize;
-    int numImagesUsed;
-    double meanReprojectionError;
-};
+using namespace cameracalib;
 
-void saveCalibrationResultsToJSON(const CalibrationResults& results, const std::string& outputFile) {
-    std::ofstream file(outputFile);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not write to output file " << outputFile << std::endl;
-        return;
-    }
-
-    file << "{\n";
-    file << "  \"camera_matrix\": [\n";
-    for (int i = 0; i < 3; i++) {
-        file << "    [";
-        for (int j = 0; j < 3; j++) {
-            file << results.cameraMatrix.at<double>(i, j);
-            if (j < 2) file << ", ";
-        }
-        file << "]";
-        if (i < 2) file << ",";
-        file << "\n";
-    }
-    file << "  ],\n";
-    
-    file << "  \"distortion_coefficients\": [";
-    for (int i = 0; i < results.distCoeffs.rows; i++) {
-        file << results.distCoeffs.at<double>(i, 0);
-        if (i < results.distCoeffs.rows - 1) file << ", ";
-    }
-    file << "],\n";
-    
-    file << "  \"rotation_vectors\": [\n";
-    for (size_t i = 0; i < results.rvecs.size(); i++) {
-        file << "    [";
-        for (int j = 0; j < 3; j++) {
-            file << results.rvecs[i].at<double>(j, 0);
-            if (j < 2) file << ", ";
-        }
-        file << "]";
-        if (i < results.rvecs.size() - 1) file << ",";
-        file << "\n";
-    }
-    file << "  ],\n";
-    
-    file << "  \"translation_vectors\": [\n";
-    for (size_t i = 0; i < results.tvecs.size(); i++) {
-        file << "    [";
-        for (int j = 0; j < 3; j++) {
-            file << results.tvecs[i].at<double>(j, 0);
-            if (j < 2) file << ", ";
+// Prints the collected stage timings and writes them to profileOut, if profiling was requested
+int finishProfile(const Profiler* profiler, const std::string& profileOut, int status) {
+    if (profiler) {
+        profiler->print(std::cout);
+        if (!profiler->saveJSON(profileOut)) {
+            return 1;
         }
-        file << "]";
-        if (i < results.tvecs.size() - 1) file << ",";
-        file << "\n";
     }
-    file << "  ],\n";
-    
-    file << "  \"calibration_success\": " << (results.success ? "true" : "false") << ",\n";
-    file << "  \"image_dimensions_wh\": [" << results.imageSize.width << ", " << results.imageSize.height << "],\n";
-    file << "  \"checkerboard_dimensions_wh\": [" << results.checkerboardSize.width << ", " << results.checkerboardSize.height << "],\n";
-    file << "  \"num_images_used\": " << results.numImagesUsed << ",\n";
-    file << "  \"mean_reprojection_error\": " << results.meanReprojectionError << "\n";
-    file << "}\n";
-    
-    file.close();
-    std::cout << "\nCalibration results successfully saved to: " << outputFile << std::endl;
+    return status;
 }
 
-CalibrationResults calibrateCamera(const std::string& imageDir, const cv::Size& checkerboardSize) {
-    std::cout << "Starting camera calibration..." << std::endl;
-    std::cout << "Image directory: " << imageDir << std::endl;
-    std::cout << "Checkerboard size: " << checkerboardSize.width << "x" << checkerboardSize.height << std::endl;
-
-    CalibrationResults results;
-    results.checkerboardSize = checkerboardSize;
-    results.success = false;
-    results.numImagesUsed = 0;
-    results.meanReprojectionError = 0.0;
-
-    // Creating vector to store vectors of 3D points for each checkerboard image
-    std::vector<std::vector<cv::Point3f>> objpoints;
-    // Creating vector to store vectors of 2D points for each checkerboard image
-    std::vector<std::vector<cv::Point2f>> imgpoints;
-
-    // Defining the world coordinates for 3D points
-    std::vector<cv::Point3f> objp;
-    for (int i = 0; i < checkerboardSize.height; i++) {
-        for (int j = 0; j < checkerboardSize.width; j++) {
-            objp.push_back(cv::Point3f(j, i, 0));
-        }
-    }
-
-    // Extracting path of individual image stored in a given directory
-    std::vector<cv::String> images;
-    std::vector<std::string> patterns = {"*.jpg", "*.jpeg", "*.png", "*.bmp", "*.tiff"};
-    
-    for (const auto& pattern : patterns) {
-        std::vector<cv::String> temp;
-        cv::glob(imageDir + "/" + pattern, temp);
-        images.insert(images.end(), temp.begin(), temp.end());
-    }
-
-    if (images.empty()) {
-        std::cerr << "Error: No images found in directory '" << imageDir << "' with supported patterns." << std::endl;
-        return results;
-    }
-
-    std::cout << "Found " << images.size() << " images." << std::endl;
-
-    cv::Mat frame, gray;
-    std::vector<cv::Point2f> corner_pts;
-    bool success;
-    cv::Size imageSize;
-    bool imageSizeSet = false;
-
-    // Looping over all the images in the directory
-    for (size_t i = 0; i < images.size(); i++) {
-        std::cout << "Processing image " << (i + 1) << "/" << images.size() << ": " 
-                  << std::filesystem::path(images[i]).filename() << "..." << std::endl;
-        
-        frame = cv::imread(images[i]);
-        if (frame.empty()) {
-            std::cout << "Warning: Could not read image " << images[i] << ". Skipping." << std::endl;
-            continue;
-        }
-
-        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
-
-        if (!imageSizeSet) {
-            imageSize = cv::Size(gray.cols, gray.rows);
-            imageSizeSet = true;
-        }
-
-        // Finding checker board corners
-        success = cv::findChessboardCorners(gray, checkerboardSize, corner_pts, 
-                                          cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_FAST_CHECK | cv::CALIB_CB_NORMALIZE_IMAGE);
-
-        if (success) {
-            cv::TermCriteria criteria(cv::TermCriteria::EPS | cv::TermCriteria::MAX_ITER, 30, 0.001);
-            cv::cornerSubPix(gray, corner_pts, cv::Size(11, 11), cv::Size(-1, -1), criteria);
-
-            objpoints.push_back(objp);
-            imgpoints.push_back(corner_pts);
-            
-            std::cout << "  -> Checkerboard found and corners refined for " 
-                      << std::filesystem::path(images[i]).filename() << std::endl;
-        } else {
-            std::cout << "  -> Checkerboard not found in " 
-                      << std::filesystem::path(images[i]).filename() << std::endl;
-        }
-    }
-
-    if (objpoints.empty() || imgpoints.empty()) {
-        std::cerr << "Error: No checkerboard corners were detected in any of the images. Calibration cannot proceed." << std::endl;
-        return results;
-    }
-
-    if (!imageSizeSet) {
-        std::cerr << "Error: Could not determine image dimensions for calibration." << std::endl;
-        return results;
-    }
-
-    std::cout << "\nPerforming camera calibration with " << objpoints.size() << " image(s) where corners were found..." << std::endl;
-
-    results.success = cv::calibrateCamera(objpoints, imgpoints, imageSize, 
-                                        results.cameraMatrix, results.distCoeffs, 
-                                        results.rvecs, results.tvecs);
-
-    if (!results.success) {
-        std::cerr << "Error: Camera calibration failed." << std::endl;
-        return results;
-    }
-
-    results.imageSize = imageSize;
-    results.numImagesUsed = objpoints.size();
-
-    std::cout << "\nCalibration successful!" << std::endl;
-    std::cout << "Camera matrix:" << std::endl << results.cameraMatrix << std::endl;
-    std::cout << "\nDistortion coefficients:" << std::endl << results.distCoeffs << std::endl;
-
-    // Calculate mean reprojection error
-    double totalError = 0.0;
-    for (size_t i = 0; i < objpoints.size(); i++) {
-        std::vector<cv::Point2f> imgpoints2;
-        cv::projectPoints(objpoints[i], results.rvecs[i], results.tvecs[i], 
-                         results.cameraMatrix, results.distCoeffs, imgpoints2);
-        double error = cv::norm(imgpoints[i], imgpoints2, cv::NORM_L2) / imgpoints2.size();
-        totalError += error;
-    }
-    results.meanReprojectionError = totalError / objpoints.size();
-    std::cout << "\nTotal (Mean) Reprojection Error: " << results.meanReprojectionError << std::endl;
-
-    return results;
-}
-
-void showUndistortedImage(const CalibrationResults& results, const std::string& imageDir) {
+void showUndistortedImage(CalibrationEngine& engine, const CalibrationResults& results, const std::string& imageDir) {
     if (!results.success) {
         std::cerr << "Cannot show undistorted image: calibration was not successful." << std::endl;
         return;
     }
 
     // Find first image to use for undistortion demonstration
-    std::vector<cv::String> images;
-    std::vector<std::string> patterns = {"*.jpg", "*.jpeg", "*.png", "*.bmp", "*.tiff"};
-    
-    for (const auto& pattern : patterns) {
-        std::vector<cv::String> temp;
-        cv::glob(imageDir + "/" + pattern, temp);
-        images.insert(images.end(), temp.begin(), temp.end());
-    }
+    std::vector<cv::String> images = findCalibrationImages(imageDir);
 
     if (images.empty()) {
         std::cerr << "No images found for undistortion demonstration." << std::endl;
@@ -240,14 +45,13 @@ void showUndistortedImage(const CalibrationResults& results, const std::string&
         return;
     }
 
-    cv::Mat dst, newCameraMatrix;
-    cv::Size imageSize(img.cols, img.rows);
-
-    // Refining the camera matrix using parameters obtained by calibration
-    newCameraMatrix = cv::getOptimalNewCameraMatrix(results.cameraMatrix, results.distCoeffs, imageSize, 1, imageSize, 0);
+    cv::Mat dst;
 
     // Method 1 to undistort the image
-    cv::undistort(img, dst, results.cameraMatrix, results.distCoeffs, newCameraMatrix);
+    {
+        ScopedTimer timer(engine.profiler(), "undistort");
+        engine.undistort(results, img, dst);
+    }
 
     // Display the undistorted image
     std::cout << "\nDisplaying undistorted image. Press any key to continue..." << std::endl;
@@ -262,45 +66,132 @@ void printUsage(const char* programName) {
     std::cout << "Options:\n";
     std::cout << "  -i, --image_dir <dir>        Directory containing checkerboard images (default: ./images)\n";
     std::cout << "  -o, --output_file <file>     Path to output JSON file (default: calibration_results.json)\n";
+    std::cout << "  -c, --calibration <file>     Undistort with a saved calibration JSON or bundle instead of calibrating\n";
     std::cout << "  -cw, --checkerboard_width <width>   Number of inner corners along width (default: 7)\n";
     std::cout << "  -ch, --checkerboard_height <height> Number of inner corners along height (default: 10)\n";
+    printDetectionUsage();
+    std::cout << "  --profile-out <file>         Write per-stage timings (count, mean, p50, p95, max) to this JSON file\n";
     std::cout << "  --no-display                 Skip displaying undistorted image\n";
+    std::cout << "  --bundle <file>              Write calibration and undistortion maps as one memory-mappable bundle\n";
+    std::cout << "  --no-map-file                Do not store the undistortion maps next to the output JSON\n";
+    std::cout << "  --map-format <float|fixed|grid> Undistortion maps as 32-bit float, 16-bit fixed point or a coarse mesh (default: float)\n";
+    std::cout << "  --grid-step <px>             Mesh spacing of --map-format grid (default: 16)\n";
+    std::cout << "  --remap <opencv|tiled>       Remap implementation used for undistortion (default: opencv)\n";
+    std::cout << "  --undistort-dir <dir|list>   Undistort every image of this directory or list file (headless)\n";
+    std::cout << "  --out-dir <dir>              Output directory for --undistort-dir\n";
+    std::cout << "  --undistort-video <file>     Undistort this video file (headless)\n";
+    std::cout << "  --out-video <file>           Output video for --undistort-video\n";
+    std::cout << "  --fourcc <code>              Codec of --out-video, e.g. mp4v or MJPG (default: same as the input)\n";
+    std::cout << "  --ring-size <n>              Frame buffers shared by the decode, remap and encode threads (default: 8)\n";
     std::cout << "  -h, --help                   Show this help message\n";
 }
 
 int main(int argc, char* argv[]) {
     std::string imageDir = "./images";
     std::string outputFile = "calibration_results.json";
+    std::string calibrationFile;
+    std::string bundleFile;
     int checkerboardWidth = 7;
     int checkerboardHeight = 10;
+    DetectionOptions detectionOptions;
+    std::string profileOut;
     bool showDisplay = true;
+    bool writeMapFile = true;
+    UndistortMapFormat mapFormat = UndistortMapFormat::Float;
+    bool mapFormatGiven = false;
+    int gridStep = kDefaultGridStep;
+    RemapKernel remapKernel = RemapKernel::OpenCV;
+    std::string undistortInput;
+    std::string undistortOutDir;
+    std::string videoInput;
+    std::string videoOutput;
+    VideoUndistortOptions videoOptions;
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
         
-        if (arg == "-h" || arg == "--help") {
-            printUsage(argv[0]);
-            return 0;
-        } else if ((arg == "-i" || arg == "--image_dir") && i + 1 < argc) {
-            imageDir = argv[++i];
-        } else if ((arg == "-o" || arg == "--output_file") && i + 1 < argc) {
-            outputFile = argv[++i];
-        } else if ((arg == "-cw" || arg == "--checkerboard_width") && i + 1 < argc) {
-            checkerboardWidth = std::stoi(argv[++i]);
-        } else if ((arg == "-ch" || arg == "--checkerboard_height") && i + 1 < argc) {
-            checkerboardHeight = std::stoi(argv[++i]);
-        } else if (arg == "--no-display") {
-            showDisplay = false;
-        } else {
-            std::cerr << "Unknown argument: " << arg << std::endl;
-            printUsage(argv[0]);
+        // Malformed values of any option end up in the catch below
+        try {
+            if (parseDetectionArgument(argc, argv, i, detectionOptions)) {
+                continue;
+            }
+
+            if (arg == "-h" || arg == "--help") {
+                printUsage(argv[0]);
+                return 0;
+            } else if ((arg == "-i" || arg == "--image_dir") && i + 1 < argc) {
+                imageDir = argv[++i];
+            } else if ((arg == "-o" || arg == "--output_file") && i + 1 < argc) {
+                outputFile = argv[++i];
+            } else if ((arg == "-c" || arg == "--calibration") && i + 1 < argc) {
+                calibrationFile = argv[++i];
+            } else if ((arg == "-cw" || arg == "--checkerboard_width") && i + 1 < argc) {
+                checkerboardWidth = std::stoi(argv[++i]);
+            } else if ((arg == "-ch" || arg == "--checkerboard_height") && i + 1 < argc) {
+                checkerboardHeight = std::stoi(argv[++i]);
+            } else if (arg == "--profile-out" && i + 1 < argc) {
+                profileOut = argv[++i];
+            } else if (arg == "--no-display") {
+                showDisplay = false;
+            } else if (arg == "--bundle" && i + 1 < argc) {
+                bundleFile = argv[++i];
+            } else if (arg == "--no-map-file") {
+                writeMapFile = false;
+            } else if (arg == "--map-format" && i + 1 < argc) {
+                std::string format = argv[++i];
+                if (!parseUndistortMapFormat(format, mapFormat)) {
+                    std::cerr << "Invalid value for " << arg << ": unknown map format " << format << std::endl;
+                    return 1;
+                }
+                mapFormatGiven = true;
+            } else if (arg == "--grid-step" && i + 1 < argc) {
+                gridStep = parseIntValue(argv[++i], 1);
+            } else if (arg == "--remap" && i + 1 < argc) {
+                std::string kernel = argv[++i];
+                if (!parseRemapKernel(kernel, remapKernel)) {
+                    std::cerr << "Invalid value for " << arg << ": unknown remap implementation " << kernel << std::endl;
+                    return 1;
+                }
+            } else if (arg == "--undistort-dir" && i + 1 < argc) {
+                undistortInput = argv[++i];
+            } else if (arg == "--out-dir" && i + 1 < argc) {
+                undistortOutDir = argv[++i];
+            } else if (arg == "--undistort-video" && i + 1 < argc) {
+                videoInput = argv[++i];
+            } else if (arg == "--out-video" && i + 1 < argc) {
+                videoOutput = argv[++i];
+            } else if (arg == "--fourcc" && i + 1 < argc) {
+                videoOptions.fourcc = argv[++i];
+                if (videoOptions.fourcc.size() != 4) {
+                    std::cerr << "Invalid value for " << arg << ": must be four characters" << std::endl;
+                    return 1;
+                }
+            } else if (arg == "--ring-size" && i + 1 < argc) {
+                // One buffer per stage at least, or the decode, remap and encode threads cannot overlap
+                videoOptions.ringSize = parseCountValue(argv[++i], 3);
+            } else {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid value for " << arg << ": " << e.what() << std::endl;
             return 1;
         }
     }
 
-    // Create image directory if it doesn't exist
-    if (!std::filesystem::exists(imageDir)) {
+    if (undistortInput.empty() != undistortOutDir.empty()) {
+        std::cerr << "Error: --undistort-dir and --out-dir must be given together." << std::endl;
+        return 1;
+    }
+    if (videoInput.empty() != videoOutput.empty()) {
+        std::cerr << "Error: --undistort-video and --out-video must be given together." << std::endl;
+        return 1;
+    }
+
+    // Create image directory if it doesn't exist; a saved calibration needs no images
+    if (calibrationFile.empty() && !std::filesystem::exists(imageDir)) {
         try {
             std::filesystem::create_directories(imageDir);
             std::cout << "Created image directory: " << imageDir << std::endl;
@@ -313,15 +204,98 @@ int main(int argc, char* argv[]) {
     }
 
     cv::Size checkerboardSize(checkerboardWidth, checkerboardHeight);
-    CalibrationResults results = calibrateCamera(imageDir, checkerboardSize);
+    std::unique_ptr<Profiler> profiler;
+    if (!profileOut.empty()) {
+        profiler.reset(new Profiler());
+    }
+
+    CalibrationEngine engine(detectionOptions);
+    engine.setProfiler(profiler.get());
+    engine.setUndistortMapFormat(mapFormat);
+    engine.setUndistortGridStep(gridStep);
+    engine.setRemapKernel(remapKernel);
+
+    CalibrationResults results;
+    if (!calibrationFile.empty() && isCalibrationBundle(calibrationFile)) {
+        ScopedTimer timer(profiler.get(), "load_bundle");
+        UndistortMaps maps;
+        if (!loadCalibrationBundle(calibrationFile, results, &maps)) {
+            return finishProfile(profiler.get(), profileOut, 1);
+        }
+        timer.stop();
+        std::cout << "Loaded calibration bundle " << calibrationFile << (maps.empty() ? "" : " with undistortion maps") << std::endl;
+
+        // Embedded maps are used as they are unless another format was asked for explicitly
+        if (!maps.empty()) {
+            if (!mapFormatGiven) {
+                engine.setUndistortMapFormat(maps.format());
+                if (maps.gridStep > 0) {
+                    engine.setUndistortGridStep(maps.gridStep);
+                }
+            }
+            engine.setUndistortMaps(maps);
+        }
+    } else if (!calibrationFile.empty()) {
+        ScopedTimer timer(profiler.get(), "load_json");
+        if (!loadCalibrationResultsFromJSON(calibrationFile, results)) {
+            return finishProfile(profiler.get(), profileOut, 1);
+        }
+        timer.stop();
+        std::cout << "Loaded calibration from " << calibrationFile << " (" << results.imageSize.width << "x"
+                  << results.imageSize.height << ", mean reprojection error " << results.meanReprojectionError << ")" << std::endl;
+    } else {
+        results = engine.calibrate(imageDir, checkerboardSize);
+        if (results.success) {
+            ScopedTimer timer(profiler.get(), "write_json");
+            if (!saveCalibrationResultsToJSON(results, outputFile)) {
+                return finishProfile(profiler.get(), profileOut, 1);
+            }
+        }
+    }
 
     if (results.success) {
-        saveCalibrationResultsToJSON(results, outputFile);
-        
+        // Build the remap tables once; later runs with the same calibration load them from disk
+        if (writeMapFile) {
+            engine.setUndistortMapFile(undistortMapPath(calibrationFile.empty() ? outputFile : calibrationFile));
+            engine.undistortMaps(results, results.imageSize);
+        }
+
+        if (!bundleFile.empty()) {
+            ScopedTimer timer(profiler.get(), "write_bundle");
+            if (!saveCalibrationBundle(results, &engine.undistortMaps(results, results.imageSize), bundleFile)) {
+                return finishProfile(profiler.get(), profileOut, 1);
+            }
+        }
+
+        // Video mode replaces the interactive preview as well
+        if (!videoInput.empty()) {
+            VideoUndistortStats stats;
+            bool undistorted = engine.undistortVideo(results, videoInput, videoOutput, videoOptions, stats);
+            printVideoUndistortStats(stats);
+            return finishProfile(profiler.get(), profileOut, undistorted ? 0 : 1);
+        }
+
+        // Batch mode replaces the interactive preview
+        if (!undistortInput.empty()) {
+            std::vector<cv::String> images = findInputImages(undistortInput);
+            if (images.empty()) {
+                std::cerr << "Error: No images found in '" << undistortInput << "'." << std::endl;
+                return finishProfile(profiler.get(), profileOut, 1);
+            }
+            try {
+                std::filesystem::create_directories(undistortOutDir);
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Could not create output directory " << undistortOutDir << ". " << e.what() << std::endl;
+                return finishProfile(profiler.get(), profileOut, 1);
+            }
+            size_t written = engine.undistortFiles(results, images, undistortOutDir);
+            return finishProfile(profiler.get(), profileOut, written == images.size() ? 0 : 1);
+        }
+
         if (showDisplay) {
-            showUndistortedImage(results, imageDir);
+            showUndistortedImage(engine, results, imageDir);
         }
     }
 
-    return results.success ? 0 : 1;
+    return finishProfile(profiler.get(), profileOut, results.success ? 0 : 1);
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "cameracalib/calibration.hpp"
+#include "cameracalib/cornerFile.hpp"
+#include "cameracalib/detection.hpp"
+#include "cameracalib/synthetic.hpp"
+#include "cameracalib/threadPool.hpp"
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace cameracalib;
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [options]\n";
+    std::cout << "Options:\n";
+    std::cout << "  -o, --out-dir <dir>          Directory for the rendered images (default: ./synthetic)\n";
+    std::cout << "  -n, --count <n>              Number of images (default: 20)\n";
+    std::cout << "  --size <w>x<h>               Image resolution (default: 1280x960)\n";
+    std::cout << "  -cw, --checkerboard_width <width>   Number of inner corners along width (default: 7)\n";
+    std::cout << "  -ch, --checkerboard_height <height> Number of inner corners along height (default: 10)\n";
+    std::cout << "  --focal <f>                  Focal length in pixels, 0 = 0.9 * width (default: 0)\n";
+    std::cout << "  --principal <cx,cy>          Principal point in pixels (default: image center)\n";
+    std::cout << "  --distortion <k1,k2,p1,p2,k3> Distortion coefficients (default: 0,0,0,0,0)\n";
+    std::cout << "  --coverage <min,max>         Fraction of the image width spanned by the board (default: 0.35,0.75)\n";
+    std::cout << "  --tilt <deg>                 Maximum out-of-plane rotation (default: 35)\n";
+    std::cout << "  --roll <deg>                 Maximum in-plane rotation (default: 20)\n";
+    std::cout << "  --noise <sigma>              Gaussian noise in gray levels (default: 2)\n";
+    std::cout << "  --blur <sigma>               Gaussian blur in pixels, 0 = none (default: 0)\n";
+    std::cout << "  --supersample <n>            Samples per pixel along each axis (default: 2)\n";
+    std::cout << "  --seed <n>                   Random seed; equal seeds give identical datasets (default: 1)\n";
+    std::cout << "  --format <ext>               Image file format, e.g. png or jpg (default: png)\n";
+    std::cout << "  --ground-truth <file>        Ground-truth JSON (default: <out-dir>/ground_truth.json)\n";
+    std::cout << "  --corners-out <file>         Also write the exact projected corners as a corner file\n";
+    std::cout << "  -j, --jobs <n>               Number of rendering threads, 0 = all cores (default: 0)\n";
+    std::cout << "  -h, --help                   Show this help message\n";
+}
+
+// Parses a comma separated list of numbers
+std::vector<double> parseList(const std::string& text) {
+    std::vector<double> values;
+    std::stringstream stream(text);
+    std::string value;
+    while (std::getline(stream, value, ',')) {
+        values.push_back(std::stod(value));
+    }
+    return values;
+}
+
+int main(int argc, char* argv[]) {
+    std::string outDir = "./synthetic";
+    std::string groundTruthFile;
+    std::string cornersFile;
+    std::string format = "png";
+    int numJobs = 0;
+    SyntheticOptions options;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        try {
+            if (arg == "-h" || arg == "--help") {
+                printUsage(argv[0]);
+                return 0;
+            } else if ((arg == "-o" || arg == "--out-dir") && i + 1 < argc) {
+                outDir = argv[++i];
+            } else if ((arg == "-n" || arg == "--count") && i + 1 < argc) {
+                options.numViews = std::stoi(argv[++i]);
+            } else if (arg == "--size" && i + 1 < argc) {
+                std::string size = argv[++i];
+                size_t x = size.find('x');
+                if (x == std::string::npos) {
+                    throw std::invalid_argument("expected <w>x<h>");
+                }
+                options.imageSize = cv::Size(std::stoi(size.substr(0, x)), std::stoi(size.substr(x + 1)));
+            } else if ((arg == "-cw" || arg == "--checkerboard_width") && i + 1 < argc) {
+                options.checkerboardSize.width = std::stoi(argv[++i]);
+            } else if ((arg == "-ch" || arg == "--checkerboard_height") && i + 1 < argc) {
+                options.checkerboardSize.height = std::stoi(argv[++i]);
+            } else if (arg == "--focal" && i + 1 < argc) {
+                options.focalLength = std::stod(argv[++i]);
+            } else if (arg == "--principal" && i + 1 < argc) {
+                std::vector<double> values = parseList(argv[++i]);
+                if (values.size() != 2) {
+                    throw std::invalid_argument("expected <cx>,<cy>");
+                }
+                options.principalPoint = cv::Point2d(values[0], values[1]);
+            } else if (arg == "--distortion" && i + 1 < argc) {
+                options.distortion = parseList(argv[++i]);
+                if (options.distortion.size() != 5) {
+                    throw std::invalid_argument("expected 5 coefficients k1,k2,p1,p2,k3");
+                }
+            } else if (arg == "--coverage" && i + 1 < argc) {
+                std::vector<double> values = parseList(argv[++i]);
+                if (values.size() != 2 || values[0] <= 0.0 || values[0] > values[1] || values[1] > 1.0) {
+                    throw std::invalid_argument("expected <min>,<max> with 0 < min <= max <= 1");
+                }
+                options.minCoverage = values[0];
+                options.maxCoverage = values[1];
+            } else if (arg == "--tilt" && i + 1 < argc) {
+                options.maxTiltDegrees = std::stod(argv[++i]);
+            } else if (arg == "--roll" && i + 1 < argc) {
+                options.maxRollDegrees = std::stod(argv[++i]);
+            } else if (arg == "--noise" && i + 1 < argc) {
+                options.noiseSigma = std::stod(argv[++i]);
+            } else if (arg == "--blur" && i + 1 < argc) {
+                options.blurSigma = std::stod(argv[++i]);
+            } else if (arg == "--supersample" && i + 1 < argc) {
+                options.supersample = std::stoi(argv[++i]);
+            } else if (arg == "--seed" && i + 1 < argc) {
+                options.seed = std::stoull(argv[++i]);
+            } else if (arg == "--format" && i + 1 < argc) {
+                format = argv[++i];
+            } else if (arg == "--ground-truth" && i + 1 < argc) {
+                groundTruthFile = argv[++i];
+            } else if (arg == "--corners-out" && i + 1 < argc) {
+                cornersFile = argv[++i];
+            } else if ((arg == "-j" || arg == "--jobs") && i + 1 < argc) {
+                numJobs = std::stoi(argv[++i]);
+            } else {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid value for " << arg << ": " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.numViews <= 0 || options.imageSize.width <= 0 || options.imageSize.height <= 0 ||
+        options.checkerboardSize.width < 2 || options.checkerboardSize.height < 2) {
+        std::cerr << "Error: Image count, image size and board size must be positive (at least 2x2 inner corners)." << std::endl;
+        return 1;
+    }
+
+    try {
+        std::filesystem::create_directories(outDir);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Could not create output directory " << outDir << ". " << e.what() << std::endl;
+        return 1;
+    }
+    if (groundTruthFile.empty()) {
+        groundTruthFile = (std::filesystem::path(outDir) / "ground_truth.json").string();
+    }
+
+    std::cout << "Generating " << options.numViews << " synthetic " << options.imageSize.width << "x" << options.imageSize.height
+              << " image(s) of a " << options.checkerboardSize.width << "x" << options.checkerboardSize.height
+              << " board (seed " << options.seed << ")" << std::endl;
+
+    std::vector<SyntheticView> views;
+    if (!generateSyntheticPoses(options, views)) {
+        return 1;
+    }
+
+    // Rendering is independent per view; poses were drawn up front so the dataset does not
+    // depend on the number of threads
+    std::vector<std::string> imagePaths(views.size());
+    std::atomic<bool> writeFailed(false);
+    ThreadPool pool(resolveNumJobs(numJobs));
+    pool.parallelFor(views.size(), [&](size_t index, int) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "synthetic_%04zu.", index);
+        imagePaths[index] = (std::filesystem::path(outDir) / (name + format)).string();
+
+        renderSyntheticView(options, index, views[index]);
+        if (!cv::imwrite(imagePaths[index], views[index].image)) {
+            writeFailed = true;
+        }
+        views[index].image.release();
+    });
+
+    if (writeFailed) {
+        std::cerr << "Error: Could not write images to " << outDir << std::endl;
+        return 1;
+    }
+    std::cout << "Images written to: " << outDir << std::endl;
+
+    if (!saveCalibrationResultsToJSON(syntheticGroundTruth(options, views), groundTruthFile)) {
+        return 1;
+    }
+
+    if (!cornersFile.empty()) {
+        CornerSet corners;
+        corners.imageSize = options.imageSize;
+        corners.checkerboardSize = options.checkerboardSize;
+        for (size_t i = 0; i < views.size(); i++) {
+            corners.viewNames.push_back(imagePaths[i]);
+            corners.imgpoints.push_back(views[i].corners);
+        }
+        if (!saveCornerFile(corners, cornersFile)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
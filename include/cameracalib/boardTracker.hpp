@@ -0,0 +1,45 @@
+#pragma once
+
+#include "cameracalib/detection.hpp"
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace cameracalib {
+
+struct TrackingStats {
+    size_t frames = 0;
+    size_t roiHits = 0;       // board found inside the predicted region
+    size_t fullSearches = 0;  // frames searched as a whole, initially or after a loss
+    size_t lost = 0;          // frames where the board was found in neither
+
+    TrackingStats& operator+=(const TrackingStats& other);
+};
+
+// Follows the board through a sequence of frames. Once found, the next frame is searched
+// and refined only inside the bounding box of the last corners, grown by options.trackMargin
+// of its size on every side; the whole frame is searched again only if that fails.
+// One tracker serves one thread.
+class BoardTracker {
+public:
+    BoardTracker() = default;
+
+    ImageDetection detect(const cv::Mat& gray, const cv::Size& checkerboardSize, const DetectionOptions& options);
+
+    // Forgets the last position, e.g. at a cut
+    void reset() { lastCorners_.clear(); }
+
+    const TrackingStats& stats() const { return stats_; }
+
+private:
+    std::vector<cv::Point2f> lastCorners_;
+    TrackingStats stats_;
+};
+
+// Region of an image of imageSize expected to contain the board given its last corners
+cv::Rect predictBoardRegion(const std::vector<cv::Point2f>& corners, const cv::Size& imageSize, double margin);
+
+void printTrackingStats(const TrackingStats& stats);
+
+} // namespace cameracalib
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+namespace cameracalib {
+
+class Profiler;
+
+struct CalibrationResults {
+    cv::Mat cameraMatrix;
+    cv::Mat distCoeffs;
+    std::vector<cv::Mat> rvecs;
+    std::vector<cv::Mat> tvecs;
+    bool success = false;
+    cv::Size imageSize;
+    cv::Size checkerboardSize;
+    int numImagesUsed = 0;
+    double meanReprojectionError = 0.0;
+};
+
+// Refined image points of all views where the board was found, i.e. everything
+// cv::calibrateCamera needs apart from the (implicit) board geometry
+struct CornerSet {
+    cv::Size imageSize;
+    cv::Size checkerboardSize;
+    std::vector<std::string> viewNames;
+    std::vector<std::vector<cv::Point2f>> imgpoints;
+};
+
+// Board corners in world coordinates, one unit per square, in findChessboardCorners order
+std::vector<cv::Point3f> checkerboardObjectPoints(const cv::Size& checkerboardSize);
+
+// Solve phase: runs cv::calibrateCamera on previously detected corners and computes
+// the mean reprojection error; does not touch any image. With initialGuess (a previous
+// calibration of the same camera and image size) the solve is seeded with its camera
+// matrix and distortion coefficients via CALIB_USE_INTRINSIC_GUESS.
+CalibrationResults solveCalibration(const CornerSet& corners, Profiler* profiler = nullptr,
+                                    const CalibrationResults* initialGuess = nullptr);
+
+// Mean over views of the per-view L2 reprojection error norm divided by the corner count
+double meanReprojectionError(const CornerSet& corners, const CalibrationResults& results);
+
+// Writes results as JSON with every double in its shortest form that reads back exactly,
+// so the output is lossless and byte-identical for identical results
+bool saveCalibrationResultsToJSON(const CalibrationResults& results, const std::string& outputFile);
+
+// Reads a file written by saveCalibrationResultsToJSON; unknown keys are ignored. Fails
+// without touching results if the file is unreadable, malformed or lacks the camera
+// matrix, distortion coefficients or image size.
+bool loadCalibrationResultsFromJSON(const std::string& inputFile, CalibrationResults& results);
+
+} // namespace cameracalib
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "cameracalib/calibration.hpp"
+#include "cameracalib/undistortion.hpp"
+
+#include <string>
+
+namespace cameracalib {
+
+// Whether file starts like a calibration bundle (as opposed to a JSON file)
+bool isCalibrationBundle(const std::string& file);
+
+// Writes results and, if given, the undistortion maps built for them into one binary file
+// that can be memory-mapped. Maps built for another calibration are left out.
+bool saveCalibrationBundle(const CalibrationResults& results, const UndistortMaps* maps, const std::string& bundleFile);
+
+// Reads a bundle. The parameters are copied out; embedded maps are returned in maps (if
+// given and present) pointing straight into the mapping, which they keep alive. maps is
+// left empty if the bundle has none.
+bool loadCalibrationBundle(const std::string& bundleFile, CalibrationResults& results, UndistortMaps* maps = nullptr);
+
+} // namespace cameracalib
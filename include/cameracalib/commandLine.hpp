@@ -0,0 +1,23 @@
+#pragma once
+
+#include "cameracalib/detection.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace cameracalib {
+
+// Parses the detection options shared by the command-line tools. If argv[i] is one of
+// them it is applied to options, i is advanced past its value and true is returned.
+// Malformed values throw std::invalid_argument or std::out_of_range.
+bool parseDetectionArgument(int argc, char* argv[], int& i, DetectionOptions& options);
+
+void printDetectionUsage();
+
+// Strict parsers for option values: the whole text must be a number no smaller than
+// minimum. Anything else throws std::invalid_argument with a message for the user.
+int parseIntValue(const std::string& text, int minimum);
+size_t parseCountValue(const std::string& text, size_t minimum = 0);
+double parseDoubleValue(const std::string& text, double minimum);
+
+} // namespace cameracalib
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "cameracalib/calibration.hpp"
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace cameracalib {
+
+struct ConvergenceOptions {
+    bool enabled = false;
+    size_t batchSize = 16;              // images detected between two trial solves
+    size_t minViews = 10;               // views with a board needed before the first trial solve
+    double intrinsicsTolerance = 0.005; // relative change of fx, fy, cx and cy
+    double distortionTolerance = 0.01;  // absolute change of k1, k2, p1 and p2
+    double errorTolerance = 0.02;       // change of the RMS reprojection error, pixels
+    int stableChecks = 2;               // consecutive trial solves within all tolerances
+};
+
+// Outcome of one trial solve and its comparison with the previous one
+struct ConvergenceCheck {
+    size_t imagesRead = 0;
+    size_t views = 0;
+    double rms = 0.0;
+    double solveMs = 0.0;
+    bool compared = false;  // a previous trial solve existed
+    double intrinsicsChange = 0.0;
+    double distortionChange = 0.0;
+    double errorChange = 0.0;
+    bool stable = false;
+};
+
+struct ConvergenceStats {
+    size_t imagesTotal = 0;
+    size_t imagesRead = 0;  // images detected before stopping
+    size_t views = 0;
+    size_t trialSolves = 0;
+    bool converged = false;
+    double detectMs = 0.0;  // wall time of detection on the images read
+    double solveMs = 0.0;   // spent in trial solves
+};
+
+// Decides when enough views have been collected: every update solves on all views so far,
+// seeded with the previous trial solve, and compares the intrinsics and the reprojection
+// error with it
+class ConvergenceMonitor {
+public:
+    explicit ConvergenceMonitor(const ConvergenceOptions& options) : options_(options) {}
+
+    // Returns true once the last stableChecks trial solves stayed within all tolerances.
+    // Does nothing while corners has fewer than minViews views.
+    bool update(const CornerSet& corners, size_t imagesRead);
+    bool converged() const;
+    const std::vector<ConvergenceCheck>& checks() const { return checks_; }
+
+private:
+    ConvergenceOptions options_;
+    cv::Mat cameraMatrix_;
+    cv::Mat distCoeffs_;
+    double rms_ = 0.0;
+    int stableRun_ = 0;
+    std::vector<ConvergenceCheck> checks_;
+};
+
+// Permutation of [0, count) in bit-reversed order, so that any prefix is spread evenly over
+// the whole range; a capture taken pose by pose is then sampled across all poses early on
+std::vector<size_t> interleavedOrder(size_t count);
+
+// Images needed and the detection time saved by stopping, net of the trial solves
+void printConvergenceStats(const ConvergenceStats& stats);
+
+} // namespace cameracalib
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "cameracalib/detection.hpp"
+#include "cameracalib/mappedFile.hpp"
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cameracalib {
+
+// 64-bit content hash over the raw file bytes, consuming eight bytes per step
+uint64_t hashBytes(const uchar* data, size_t size);
+
+struct CornerCacheKey {
+    uint64_t contentHash = 0;
+    uint64_t fileSize = 0;
+    int64_t modifiedTime = 0;
+    int32_t boardWidth = 0;
+    int32_t boardHeight = 0;
+    uint32_t detectionFlags = 0;
+
+    bool operator==(const CornerCacheKey& other) const {
+        return contentHash == other.contentHash && fileSize == other.fileSize && modifiedTime == other.modifiedTime &&
+               boardWidth == other.boardWidth && boardHeight == other.boardHeight && detectionFlags == other.detectionFlags;
+    }
+};
+
+struct CornerCacheKeyHasher {
+    size_t operator()(const CornerCacheKey& key) const {
+        return static_cast<size_t>(key.contentHash ^ (key.fileSize * 0x9E3779B97F4A7C15ULL) ^
+                                   (static_cast<uint64_t>(key.modifiedTime) << 1) ^ key.detectionFlags);
+    }
+};
+
+// Persistent map from image file (content hash, size, mtime) and detection settings to
+// the refined corners, or a not-found marker. Images the prefilter rejected without a board
+// search are not stored. Lookups and stores are thread-safe.
+class CornerCache {
+public:
+    // Maps an existing cache file; a missing or incompatible file leaves the cache empty
+    bool load(const std::string& path);
+
+    // Writes all loaded and newly stored entries to a temporary file and renames it into place
+    bool save(const std::string& path);
+
+    // Builds the cache key for an image from its bytes and file metadata
+    static bool makeKey(const std::string& imagePath, const std::vector<uchar>& fileData, const cv::Size& checkerboardSize,
+                        uint32_t detectionFlags, CornerCacheKey& key);
+
+    bool lookup(const CornerCacheKey& key, ImageDetection& detection);
+    void store(const CornerCacheKey& key, const ImageDetection& detection);
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+    size_t size() const { return entries_.size(); }
+    // True if entries were stored since the last load or save
+    bool dirty() const { return dirty_; }
+
+private:
+    struct Entry {
+        CornerCacheKey key;
+        bool found = false;
+        cv::Size imageSize;
+        const cv::Point2f* corners = nullptr;  // into the mapped file or ownedCorners_
+        size_t cornerCount = 0;
+    };
+
+    MappedFile mapped_;
+    std::vector<Entry> entries_;
+    std::unordered_map<CornerCacheKey, size_t, CornerCacheKeyHasher> index_;
+    std::vector<std::unique_ptr<std::vector<cv::Point2f>>> ownedCorners_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+    bool dirty_ = false;
+    mutable std::mutex mutex_;
+};
+
+} // namespace cameracalib
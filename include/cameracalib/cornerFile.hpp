@@ -0,0 +1,16 @@
+#pragma once
+
+#include "cameracalib/calibration.hpp"
+
+#include <string>
+
+namespace cameracalib {
+
+// Writes corners to a compact binary corner file for a later solve-only run
+bool saveCornerFile(const CornerSet& corners, const std::string& outputFile);
+
+// Appends the views of a corner file to corners; the image and board sizes must match
+// those already present unless corners is still empty
+bool loadCornerFile(const std::string& inputFile, CornerSet& corners);
+
+} // namespace cameracalib
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "cameracalib/convergence.hpp"
+#include "cameracalib/prefilter.hpp"
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cameracalib {
+
+class CornerCache;
+class Profiler;
+class ThreadPool;
+
+enum class DecodeMode {
+    Color,     // full-resolution BGR decode followed by cvtColor
+    Gray,      // full-resolution decode straight to grayscale
+    Reduced2,  // board search on a half-resolution grayscale decode
+    Reduced4,  // board search on a quarter-resolution grayscale decode
+};
+
+enum class DetectorBackend {
+    Classic,      // findChessboardCorners followed by cornerSubPix
+    SectorBased,  // findChessboardCornersSB, subpixel accurate without cornerSubPix
+    Auto,         // picked by CalibrationEngine from a trial of both on the first images; Classic elsewhere
+};
+
+struct DetectionOptions {
+    int numJobs = 1;                // worker threads, 0 = all cores
+    bool pipeline = false;          // run read/decode/gray/detect/refine as separate stages
+    size_t queueDepth = 8;          // capacity of each queue between pipeline stages
+    std::vector<int> stageWorkers;  // per-stage worker counts, empty = derived from numJobs
+    bool pipelineStats = false;     // print stage occupancy and queue depths
+    std::string cornerCachePath;    // on-disk corner cache, empty = disabled
+    size_t shardIndex = 0;          // only process images with index % shardCount == shardIndex
+    size_t shardCount = 1;
+    DecodeMode decodeMode = DecodeMode::Color;
+    bool pyramid = false;           // search on a downscaled image, refine at full resolution
+    double pyramidScale = 0.0;      // downscale factor of the search image, 0 = automatic
+    bool track = false;             // search sequential frames near the last board position first
+    double trackMargin = 0.25;      // tracked region grows by this fraction of the board's bounding box per side
+    DetectorBackend detector = DetectorBackend::Classic;
+    size_t detectorTrialImages = 5; // images both backends are timed on for DetectorBackend::Auto
+    PrefilterOptions prefilter;     // skips the board search on images that cannot contain the board
+    ConvergenceOptions convergence; // stops reading images once trial solves agree (CalibrationEngine only)
+    Profiler* profiler = nullptr;   // receives per-stage timings if set, not owned
+};
+
+struct ImageDetection {
+    bool imageRead = false;
+    bool found = false;
+    cv::Size imageSize;  // full resolution; empty if only a reduced decode was needed
+    std::vector<cv::Point2f> corners;
+    bool fromCache = false;
+    PrefilterOutcome prefilter;
+};
+
+extern const int kChessboardFlags;
+extern const int kChessboardSBFlags;
+
+bool parseDecodeMode(const std::string& name, DecodeMode& mode);
+const char* decodeModeName(DecodeMode mode);
+
+bool parseDetectorBackend(const std::string& name, DetectorBackend& backend);
+const char* detectorBackendName(DetectorBackend backend);
+
+// Factor by which the image searched for the board is smaller than the full image
+int decodeModeScale(DecodeMode mode);
+
+// Decodes file bytes to the grayscale image the board is searched on
+cv::Mat decodeSearchImage(const std::vector<uchar>& fileData, DecodeMode mode, Profiler* profiler = nullptr);
+
+// Identifies the detection settings in corner cache keys
+uint32_t detectionCacheFlags(const DetectionOptions& options);
+
+// Number of worker threads to use for numJobs, resolving 0 to the number of cores
+int resolveNumJobs(int numJobs);
+
+// All images with a supported extension in imageDir, in glob order
+std::vector<cv::String> findCalibrationImages(const std::string& imageDir);
+
+// Images of a directory (as findCalibrationImages) or the paths listed one per line in a
+// text file; empty lines and lines starting with '#' are skipped
+std::vector<cv::String> findInputImages(const std::string& dirOrList);
+
+bool findCheckerboardCorners(const cv::Mat& gray, const cv::Size& checkerboardSize, std::vector<cv::Point2f>& corners,
+                             Profiler* profiler = nullptr, DetectorBackend backend = DetectorBackend::Classic);
+void refineCheckerboardCorners(const cv::Mat& gray, std::vector<cv::Point2f>& corners);
+
+// Searches search for the board, behind the prefilter if options.prefilter is enabled, and
+// records the prefilter outcome in detection. Returns whether the board was found.
+bool searchCheckerboard(const cv::Mat& search, const cv::Size& checkerboardSize, ImageDetection& detection,
+                        const DetectionOptions& options);
+
+// Maps corners found on a downscaled copy of gray back to full resolution and refines them
+// there; the subpixel windows only read gray around each corner
+void refineScaledCorners(const cv::Mat& gray, double scaleX, double scaleY, std::vector<cv::Point2f>& corners);
+
+// Downscale factor for the coarse board search on an image of imageSize, chosen so that the
+// board squares still span enough pixels if the board covers a third of the shorter side;
+// keeps the search image at a roughly constant size regardless of sensor resolution
+double pyramidSearchScale(const cv::Size& imageSize, const cv::Size& checkerboardSize);
+
+// Image the board is searched on: gray itself, or in pyramid mode a downscaled copy.
+// decodeScale is the factor by which gray is already smaller than the full image.
+cv::Mat makeSearchImage(const cv::Mat& gray, int decodeScale, const cv::Size& checkerboardSize, const DetectionOptions& options);
+
+// Refines corners found on search at the resolution of fullGray; corners the sector-based
+// detector found at full resolution are already subpixel accurate and left as they are
+void refineSearchCorners(const cv::Mat& fullGray, const cv::Mat& search, std::vector<cv::Point2f>& corners,
+                         Profiler* profiler = nullptr, DetectorBackend backend = DetectorBackend::Classic);
+
+// Finds and refines the board corners in a full-resolution grayscale image
+ImageDetection detectCheckerboardInGray(const cv::Mat& gray, const cv::Size& checkerboardSize, const DetectionOptions& options);
+
+// Converts a BGR frame to gray, finds and refines the board corners
+ImageDetection detectCheckerboardInImage(const cv::Mat& frame, const cv::Size& checkerboardSize,
+                                         const DetectionOptions& options = DetectionOptions());
+
+// Detects the board in encoded image bytes. In the reduced modes the full-resolution
+// image is only decoded once the board has been found on the reduced one.
+ImageDetection detectCheckerboardInFile(const std::vector<uchar>& fileData, const cv::Size& checkerboardSize,
+                                        const DetectionOptions& options);
+
+// Detects the board in one image file, consulting and filling cache if given;
+// fileBuffer is scratch space for the file bytes that keeps its capacity between calls
+ImageDetection detectCheckerboard(const std::string& imagePath, const cv::Size& checkerboardSize, const DetectionOptions& options,
+                                  CornerCache* cache, std::vector<uchar>& fileBuffer);
+
+void logDetection(const ImageDetection& detection, const std::string& imagePath);
+
+// Detects the board in every image on pool; results are indexed like images.
+// fileBuffers provides one scratch buffer per pool worker and is grown if needed.
+std::vector<ImageDetection> detectCheckerboards(const std::vector<cv::String>& images, const cv::Size& checkerboardSize,
+                                                const DetectionOptions& options, ThreadPool& pool, CornerCache* cache,
+                                                std::vector<std::vector<uchar>>& fileBuffers);
+
+// Number of threads the pipeline stages of options run on: one per stage worker
+int pipelineThreadCount(const DetectionOptions& options);
+
+// Runs the per-image work as five stages (file read, decode, grayscale, detect, subpixel
+// refine) connected by bounded queues, so that disk I/O, decoding and detection of
+// different images overlap while at most queueDepth images wait between two stages.
+// Every stage worker occupies one thread of stagePool for the whole call, so the pool
+// needs at least pipelineThreadCount(options) threads and can be kept for later calls.
+std::vector<ImageDetection> detectCheckerboardsPipelined(const std::vector<cv::String>& images, const cv::Size& checkerboardSize,
+                                                         const DetectionOptions& options, ThreadPool& stagePool, CornerCache* cache);
+
+} // namespace cameracalib
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "cameracalib/detection.hpp"
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace cameracalib {
+
+// Speed and accuracy of one detector backend on a sample of images
+struct DetectorTrial {
+    DetectorBackend backend = DetectorBackend::Classic;
+    size_t images = 0;
+    size_t found = 0;
+    double meanMs = 0.0;         // search plus refinement per image
+    double homographyRms = 0.0;  // RMS distance of the corners to the best-fitting homography of the board, pixels
+};
+
+// RMS residual of corners against the homography of the flat board that fits them best.
+// Lens distortion adds the same amount for every detector, so differences between
+// backends on the same views reflect their corner accuracy.
+double cornerHomographyRms(const std::vector<cv::Point2f>& corners, const cv::Size& checkerboardSize);
+
+// Runs the full detection (search and refinement, as configured by options) with every
+// concrete backend on the given full-resolution grayscale images
+std::vector<DetectorTrial> runDetectorTrials(const std::vector<cv::Mat>& grays, const cv::Size& checkerboardSize,
+                                             const DetectionOptions& options);
+
+// Fastest backend among those that found the board in as many images as any other and
+// are no less accurate than the most accurate one by more than a quarter pixel
+DetectorBackend chooseDetectorBackend(const std::vector<DetectorTrial>& trials);
+
+void printDetectorTrials(const std::vector<DetectorTrial>& trials);
+
+} // namespace cameracalib
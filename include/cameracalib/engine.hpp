@@ -0,0 +1,113 @@
+#pragma once
+
+#include "cameracalib/calibration.hpp"
+#include "cameracalib/detection.hpp"
+#include "cameracalib/keyframes.hpp"
+#include "cameracalib/tiledRemap.hpp"
+#include "cameracalib/undistortion.hpp"
+#include "cameracalib/videoUndistortion.hpp"
+
+#include <opencv2/core.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cameracalib {
+
+class CornerCache;
+class ThreadPool;
+
+// Long-lived calibration context for tools and in-process services. It owns the worker
+// pool, the threads of the detection pipeline, per-worker scratch buffers and the corner
+// cache, so repeated jobs neither spawn threads nor reload the cache. Jobs on one engine
+// run one after another.
+class CalibrationEngine {
+public:
+    explicit CalibrationEngine(const DetectionOptions& options = DetectionOptions());
+    CalibrationEngine(const CalibrationEngine&) = delete;
+    CalibrationEngine& operator=(const CalibrationEngine&) = delete;
+    ~CalibrationEngine();
+
+    const DetectionOptions& options() const { return options_; }
+
+    // Sends per-stage timings of subsequent jobs to profiler (not owned, may be null)
+    void setProfiler(Profiler* profiler) { options_.profiler = profiler; }
+    Profiler* profiler() const { return options_.profiler; }
+    ThreadPool& threadPool() { return *pool_; }
+
+    // Detection phase: finds and refines the board corners in the given images.
+    // Returns false if no image could be read or no board was found. With
+    // options().convergence the images are read in interleaved batches until trial solves
+    // agree, and the remaining ones are left out.
+    bool detectCorners(const std::vector<cv::String>& images, const cv::Size& checkerboardSize, CornerSet& corners);
+    bool detectCorners(const std::string& imageDir, const cv::Size& checkerboardSize, CornerSet& corners);
+
+    // Detection on the keyframes of a calibration video: a selection thread samples frames
+    // and drops near-duplicates and blurry ones ahead of detection on the worker pool.
+    // Views are named after their frame index. The corner cache is not used; with
+    // options().track each frame is searched near the last board position first.
+    bool detectCornersInVideo(const std::string& videoFile, const cv::Size& checkerboardSize,
+                              const KeyframeOptions& keyframeOptions, CornerSet& corners);
+
+    CalibrationResults solve(const CornerSet& corners, const CalibrationResults* initialGuess = nullptr);
+
+    // Detection followed by the solve, optionally seeded with a previous calibration (see
+    // solveCalibration). Together with the corner cache only new images are detected.
+    CalibrationResults calibrate(const std::string& imageDir, const cv::Size& checkerboardSize,
+                                 const CalibrationResults* initialGuess = nullptr);
+    CalibrationResults calibrateVideo(const std::string& videoFile, const cv::Size& checkerboardSize,
+                                      const KeyframeOptions& keyframeOptions = KeyframeOptions(),
+                                      const CalibrationResults* initialGuess = nullptr);
+
+    // Undistorts src through remap tables that are built (or loaded from the map file) on
+    // first use and reused until the calibration or image size changes
+    void undistort(const CalibrationResults& results, const cv::Mat& src, cv::Mat& dst);
+
+    // Persists the undistortion maps in this file and reuses them across runs; empty keeps
+    // them in memory only
+    void setUndistortMapFile(const std::string& mapFile) { mapFile_ = mapFile; }
+    void setUndistortMapFormat(UndistortMapFormat format) { mapFormat_ = format; }
+    void setUndistortGridStep(int gridStep) { gridStep_ = gridStep; }
+    void setRemapKernel(RemapKernel kernel) { remapKernel_ = kernel; }
+    const UndistortMaps& undistortMaps(const CalibrationResults& results, const cv::Size& imageSize);
+
+    // Adopts maps obtained elsewhere, e.g. from a calibration bundle; they are used as long
+    // as they match the calibration, image size, format and grid step of later requests
+    void setUndistortMaps(const UndistortMaps& maps) { maps_ = maps; }
+
+    // Batch undistortion: every image is read, remapped through the shared maps and
+    // re-encoded into outDir under its original file name and format, spread over the
+    // worker pool. Images whose size differs from the calibration are skipped, and nothing
+    // is written if two images share a file name. Returns the number of images written.
+    size_t undistortFiles(const CalibrationResults& results, const std::vector<cv::String>& images, const std::string& outDir);
+
+    // Streams a video through the shared maps; the remap kernel and worker pool of the engine
+    // override those in options
+    bool undistortVideo(const CalibrationResults& results, const std::string& inputFile, const std::string& outputFile,
+                        VideoUndistortOptions options, VideoUndistortStats& stats);
+
+private:
+    CornerCache* cornerCache();
+    // Threads for the stages of options().pipeline, started on first use
+    ThreadPool& stagePool(const DetectionOptions& options);
+    std::vector<ImageDetection> detectUntilConverged(const std::vector<cv::String>& images, const cv::Size& checkerboardSize,
+                                                     const DetectionOptions& options, CornerCache* cache);
+
+    DetectionOptions options_;
+    std::unique_ptr<ThreadPool> pool_;
+    std::unique_ptr<ThreadPool> stagePool_;
+    std::unique_ptr<CornerCache> cache_;
+    bool cacheLoaded_ = false;
+    std::vector<std::vector<uchar>> fileBuffers_;  // one per pool worker
+    std::string mapFile_;
+    UndistortMapFormat mapFormat_ = UndistortMapFormat::Float;
+    int gridStep_ = kDefaultGridStep;
+    RemapKernel remapKernel_ = RemapKernel::OpenCV;
+    UndistortMaps maps_;
+};
+
+// One-shot convenience wrapper around a temporary CalibrationEngine
+CalibrationResults calibrateCamera(const std::string& imageDir, const cv::Size& checkerboardSize,
+                                   const DetectionOptions& options = DetectionOptions());
+
+} // namespace cameracalib
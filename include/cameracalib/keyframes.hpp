@@ -0,0 +1,62 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cameracalib {
+
+struct KeyframeOptions {
+    int sampleStep = 3;           // only every n-th frame is retrieved and examined; the rest are just grabbed
+    int thumbnailWidth = 160;     // width of the grayscale thumbnails compared for near-duplicates
+    double minSharpness = 100.0;  // variance of the Laplacian below which a frame counts as blurry, 0 = off
+    double minDifference = 6.0;   // mean absolute gray-level difference to every accepted thumbnail, 0 = off
+    size_t maxFrames = 0;         // stop reading once this many keyframes were accepted, 0 = unlimited
+};
+
+struct KeyframeStats {
+    size_t framesRead = 0;
+    size_t sampled = 0;
+    size_t duplicates = 0;
+    size_t blurry = 0;
+    size_t accepted = 0;
+};
+
+// Frame of a calibration video handed to corner detection
+struct Keyframe {
+    int frameIndex = -1;
+    cv::Mat gray;  // full resolution
+};
+
+// Decides for each sampled frame whether it can add information to the calibration. The
+// near-duplicate test compares a small thumbnail against those of all accepted frames and
+// runs first; only frames that pass it pay for the full-resolution blur measure.
+class KeyframeSelector {
+public:
+    explicit KeyframeSelector(const KeyframeOptions& options = KeyframeOptions());
+
+    // gray is the full-resolution grayscale frame
+    bool accept(const cv::Mat& gray);
+
+    const KeyframeStats& stats() const { return stats_; }
+    KeyframeStats& stats() { return stats_; }
+
+private:
+    KeyframeOptions options_;
+    KeyframeStats stats_;
+    std::vector<cv::Mat> thumbnails_;  // of the accepted frames
+    cv::Mat thumbnail_;
+    cv::Mat laplacian_;
+};
+
+// Variance of the Laplacian of gray; low values mean little edge energy, i.e. blur.
+// laplacian is scratch space that keeps its allocation between calls.
+double frameSharpness(const cv::Mat& gray, cv::Mat& laplacian);
+
+// View name of a video frame in corner files and logs, e.g. frame_000120
+std::string keyframeName(int frameIndex);
+
+void printKeyframeStats(const KeyframeStats& stats);
+
+} // namespace cameracalib
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cameracalib {
+
+// Written into binary file headers so files from a host with another byte order are rejected
+const uint32_t kByteOrderMark = 0x01020304;
+
+bool readFileBytes(const std::string& path, std::vector<uchar>& data);
+
+// Read-only view of a whole file, memory-mapped where the platform allows it
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool open(const std::string& path);
+    void close();
+
+    const uchar* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uchar* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    std::vector<uchar> buffer_;
+#endif
+};
+
+} // namespace cameracalib
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace cameracalib {
+
+struct PrefilterOptions {
+    bool enabled = false;
+    int thumbnailWidth = 320;        // the statistics are computed on a copy at most this wide
+    double minContrast = 10.0;       // standard deviation of the gray levels
+    double minSharpness = 10.0;      // variance of the Laplacian
+    double minSaddleFraction = 0.5;  // saddle points found relative to the inner corners of the board
+    double auditFraction = 0.0;      // share of rejected images searched anyway to measure false rejects
+};
+
+// Cheap statistics of the image the board would be searched on
+struct PrefilterScores {
+    double contrast = 0.0;
+    double sharpness = 0.0;
+    int saddlePoints = 0;
+    uint64_t thumbnailHash = 0;  // hash of every pixel of the thumbnail
+};
+
+// What the prefilter did with one image
+struct PrefilterOutcome {
+    bool rejected = false;
+    bool audited = false;     // rejected, but searched in full anyway
+    bool auditFound = false;  // that search found the board, i.e. a false reject
+    double filterMs = 0.0;
+    double auditMs = 0.0;     // duration of the full search of an audited image
+};
+
+struct PrefilterStats {
+    size_t checked = 0;
+    size_t rejected = 0;
+    size_t audited = 0;
+    size_t falseRejects = 0;
+    double filterMs = 0.0;
+    double auditMs = 0.0;
+
+    void add(const PrefilterOutcome& outcome);
+};
+
+// Contrast and sharpness of a thumbnail of gray and the number of saddle points on it: local
+// maxima of -det(Hessian), the response of a checkerboard's inner corners, above a tenth of
+// the strongest one
+PrefilterScores computePrefilterScores(const cv::Mat& gray, const PrefilterOptions& options);
+
+// False if the scores rule out a complete board of checkerboardSize inner corners
+bool prefilterAccepts(const PrefilterScores& scores, const cv::Size& checkerboardSize, const PrefilterOptions& options);
+
+// Whether a rejected image should be audited; depends only on the thumbnail hash of its
+// scores, so the sample is the same in every run regardless of thread scheduling
+bool prefilterAuditSelects(const PrefilterScores& scores, double auditFraction);
+
+// Rejections, the time spent filtering and, from the audited sample, the false-reject rate
+// and the estimated time saved
+void printPrefilterStats(const PrefilterStats& stats);
+
+} // namespace cameracalib
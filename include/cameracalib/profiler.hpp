@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cameracalib {
+
+struct TimingStats {
+    size_t count = 0;
+    double totalMs = 0.0;
+    double minMs = 0.0;
+    double meanMs = 0.0;
+    double p50Ms = 0.0;
+    double p95Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+// Summarizes a set of durations in milliseconds (nearest-rank percentiles)
+TimingStats computeTimingStats(std::vector<double> samplesMs);
+
+// Collects per-stage duration samples from any number of threads
+class Profiler {
+public:
+    Profiler();
+
+    void record(const std::string& stage, double milliseconds);
+
+    // Stages in the order they were first recorded
+    std::vector<std::pair<std::string, TimingStats>> summary() const;
+
+    double wallTimeMs() const;
+
+    void print(std::ostream& out) const;
+    bool saveJSON(const std::string& outputFile) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::string> stageOrder_;
+    std::unordered_map<std::string, std::vector<double>> samples_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Records the lifetime of the object as one sample of stage; does nothing without a profiler
+class ScopedTimer {
+public:
+    ScopedTimer(Profiler* profiler, const char* stage)
+        : profiler_(profiler), stage_(stage), start_(profiler ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point()) {}
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+    ~ScopedTimer() { stop(); }
+
+    // Ends the measurement early, optionally under a different stage name
+    void stop(const char* stage = nullptr) {
+        if (profiler_) {
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_;
+            profiler_->record(stage ? stage : stage_, elapsed.count());
+            profiler_ = nullptr;
+        }
+    }
+
+private:
+    Profiler* profiler_;
+    const char* stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace cameracalib
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "cameracalib/calibration.hpp"
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace cameracalib {
+
+// Camera, board and imaging conditions of a synthetic calibration dataset
+struct SyntheticOptions {
+    cv::Size imageSize = cv::Size(1280, 960);
+    cv::Size checkerboardSize = cv::Size(7, 10);  // inner corners, as for detection
+    double focalLength = 0.0;                     // pixels, 0 = 0.9 * image width
+    cv::Point2d principalPoint = cv::Point2d(-1.0, -1.0);  // pixels, negative = image center
+    std::vector<double> distortion = {0.0, 0.0, 0.0, 0.0, 0.0};  // k1, k2, p1, p2, k3
+    int numViews = 20;
+    double minCoverage = 0.35;   // fraction of the image width spanned by the board
+    double maxCoverage = 0.75;
+    double maxTiltDegrees = 35.0;  // rotation out of the image plane around x and y
+    double maxRollDegrees = 20.0;  // rotation in the image plane
+    double noiseSigma = 2.0;       // gray levels of additive Gaussian noise
+    double blurSigma = 0.0;        // pixels of Gaussian blur, 0 = none
+    int supersample = 2;           // samples per pixel along each axis
+    uint64_t seed = 1;
+};
+
+// One rendered view with its exact pose and projected inner corners
+struct SyntheticView {
+    cv::Mat image;  // 8-bit grayscale
+    cv::Mat rvec;
+    cv::Mat tvec;
+    std::vector<cv::Point2f> corners;  // in checkerboardObjectPoints order
+};
+
+// Camera matrix (3x3) and distortion coefficients (5x1) described by the options
+cv::Mat syntheticCameraMatrix(const SyntheticOptions& options);
+cv::Mat syntheticDistCoeffs(const SyntheticOptions& options);
+
+// Draws numViews random board poses that keep the whole board, including its white
+// border, inside the image. Deterministic for a given seed.
+bool generateSyntheticPoses(const SyntheticOptions& options, std::vector<SyntheticView>& views);
+
+// Renders view.image from view.rvec/view.tvec: the board is rasterized through the
+// distorted camera with supersampling, then blurred and corrupted with noise. Each
+// view draws its noise from its own generator, so views can be rendered in parallel.
+void renderSyntheticView(const SyntheticOptions& options, size_t viewIndex, SyntheticView& view);
+
+// Ground truth in the form returned by a calibration: exact intrinsics and poses
+// with zero reprojection error
+CalibrationResults syntheticGroundTruth(const SyntheticOptions& options, const std::vector<SyntheticView>& views);
+
+} // namespace cameracalib
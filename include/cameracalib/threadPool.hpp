@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cameracalib {
+
+// Fixed set of worker threads that is kept alive between jobs. The calling thread
+// takes part in every job, so a pool of size n spawns n - 1 threads.
+class ThreadPool {
+public:
+    explicit ThreadPool(int numThreads);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+    // Calls task(index, worker) for every index in [0, count), with worker in [0, size()),
+    // and returns once all calls finished. Concurrent callers are served one after another;
+    // the first exception thrown by a task is rethrown here.
+    void parallelFor(size_t count, const std::function<void(size_t index, int worker)>& task);
+
+private:
+    void workerLoop(int worker);
+    void runTasks(int worker);
+
+    std::vector<std::thread> workers_;
+    std::mutex jobMutex_;  // serializes parallelFor callers
+
+    std::mutex mutex_;
+    std::condition_variable jobReady_;
+    std::condition_variable jobDone_;
+    const std::function<void(size_t, int)>* task_ = nullptr;
+    size_t count_ = 0;
+    size_t nextIndex_ = 0;
+    size_t generation_ = 0;
+    int activeWorkers_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr error_;
+};
+
+} // namespace cameracalib
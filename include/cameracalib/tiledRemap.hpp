@@ -0,0 +1,34 @@
+#pragma once
+
+#include "cameracalib/undistortion.hpp"
+
+#include <opencv2/core.hpp>
+#include <string>
+
+namespace cameracalib {
+
+class ThreadPool;
+
+enum class RemapKernel {
+    OpenCV,  // cv::remap
+    Tiled    // remapTiled, falls back to cv::remap for unsupported image types
+};
+
+bool parseRemapKernel(const std::string& name, RemapKernel& kernel);
+const char* remapKernelName(RemapKernel kernel);
+
+// Whether remapTiled handles src (8-bit, 1 or 3 channels)
+bool tiledRemapSupports(const cv::Mat& src);
+
+// Bilinear remap through float, fixed-point or grid undistortion maps with the same border
+// handling as remapImage. The output is processed in tiles small enough that a tile's maps,
+// destination and source footprint stay in L2; positions are rounded to 1/32 pixel and
+// interpolated in integer arithmetic, with SSE2 for interior pixels on x86-64. Tiles are
+// spread over pool if given. Results can differ from cv::remap by one gray level due to
+// rounding.
+void remapTiled(const UndistortMaps& maps, const cv::Mat& src, cv::Mat& dst, ThreadPool* pool = nullptr);
+
+// Dispatches to cv::remap or remapTiled
+void remapImage(const UndistortMaps& maps, const cv::Mat& src, cv::Mat& dst, RemapKernel kernel, ThreadPool* pool = nullptr);
+
+} // namespace cameracalib
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "cameracalib/calibration.hpp"
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+namespace cameracalib {
+
+class MappedFile;
+
+enum class UndistortMapFormat {
+    Float,  // CV_32FC1 x and y maps, 8 bytes per pixel
+    Fixed,  // CV_16SC2 integer positions + CV_16UC1 interpolation table indices, 6 bytes per pixel
+    Grid    // CV_32FC2 source positions every gridStep pixels, interpolated bilinearly while remapping
+};
+
+const int kDefaultGridStep = 16;
+
+// Source position error of compact maps relative to exact float maps
+struct UndistortMapAccuracy {
+    double maxError = 0.0;   // pixels
+    double meanError = 0.0;  // pixels
+};
+
+// Remap tables for one calibration and image size. Built once (or loaded from a map file)
+// and then applied to any number of frames with remapImage.
+struct UndistortMaps {
+    cv::Size imageSize;
+    uint64_t fingerprint = 0;  // calibrationFingerprint the maps were built for
+    cv::Mat newCameraMatrix;
+    cv::Mat map1;  // Float: CV_32FC1 source x; Fixed: CV_16SC2 integer source x/y; Grid: CV_32FC2 mesh nodes
+    cv::Mat map2;  // Float: CV_32FC1 source y; Fixed: CV_16UC1 1/32 pixel fractions; Grid: empty
+    int gridStep = 0;  // Grid: destination pixels between neighbouring mesh nodes
+    std::shared_ptr<MappedFile> storage;  // keeps a loaded map file mapped; map1/map2 point into it
+
+    bool empty() const { return map1.empty(); }
+    UndistortMapFormat format() const {
+        if (gridStep > 0) {
+            return UndistortMapFormat::Grid;
+        }
+        return map1.type() == CV_16SC2 ? UndistortMapFormat::Fixed : UndistortMapFormat::Float;
+    }
+};
+
+// Refined camera matrix keeping all source pixels (alpha = 1) for images of imageSize
+cv::Mat optimalNewCameraMatrix(const CalibrationResults& results, const cv::Size& imageSize);
+
+// Undistorts src with the calibrated camera matrix and distortion coefficients.
+// Rebuilds the maps on every call; prefer UndistortMaps for more than one image.
+void undistortImage(const CalibrationResults& results, const cv::Mat& src, cv::Mat& dst);
+
+// Identifies the camera matrix, distortion coefficients and image size the maps depend on
+uint64_t calibrationFingerprint(const CalibrationResults& results, const cv::Size& imageSize);
+
+// Builds maps of the given format: float maps directly, fixed-point maps by cv::convertMaps,
+// grid maps by evaluating the lens model at the mesh nodes only. For the compact formats the
+// position error against exact float maps is measured and stored in accuracy if given.
+void buildUndistortMaps(const CalibrationResults& results, const cv::Size& imageSize, UndistortMaps& maps,
+                        UndistortMapFormat format = UndistortMapFormat::Float, UndistortMapAccuracy* accuracy = nullptr,
+                        int gridStep = kDefaultGridStep);
+
+// Mesh nodes needed to cover imageSize with the given step, including the last row and column
+cv::Size undistortGridSize(const cv::Size& imageSize, int gridStep);
+
+// Source positions of count destination pixels of row y starting at x0, for any map format
+void mapRowPositions(const UndistortMaps& maps, int y, int x0, int count, float* xs, float* ys);
+
+// Compares the positions of maps with exact float maps computed strip by strip, so the
+// measurement needs no full-resolution float maps in memory
+UndistortMapAccuracy measureUndistortMapAccuracy(const CalibrationResults& results, const UndistortMaps& maps);
+
+bool parseUndistortMapFormat(const std::string& name, UndistortMapFormat& format);
+const char* undistortMapFormatName(UndistortMapFormat format);
+
+// Applies the maps with cv::remap (bilinear, black outside the source image); grid maps are
+// expanded a strip of rows at a time. src must have maps.imageSize.
+void remapImage(const UndistortMaps& maps, const cv::Mat& src, cv::Mat& dst);
+
+// Map file stored next to a calibration JSON: results.json -> results.maps
+std::string undistortMapPath(const std::string& calibrationFile);
+
+bool saveUndistortMaps(const UndistortMaps& maps, const std::string& mapFile);
+
+// Serialized size of maps and the serialization itself, as stored in a map file; used to
+// embed maps in other files
+size_t undistortMapsBytes(const UndistortMaps& maps);
+bool writeUndistortMaps(std::ostream& out, const UndistortMaps& maps);
+
+// Maps serialized at [offset, offset + size) of a mapped file, pointing into the mapping.
+// The start of the region must be aligned to at least 8 bytes.
+bool viewUndistortMaps(const std::shared_ptr<MappedFile>& storage, size_t offset, size_t size, uint64_t fingerprint,
+                       UndistortMaps& maps);
+
+// Memory-maps a map file; fails if it is missing, corrupt or was built for another fingerprint
+bool loadUndistortMaps(const std::string& mapFile, uint64_t fingerprint, UndistortMaps& maps);
+
+// Loads the map file if it matches results, imageSize, format and grid step; otherwise builds
+// the maps and (re)writes the file. An empty mapFile only builds the maps.
+bool loadOrBuildUndistortMaps(const CalibrationResults& results, const cv::Size& imageSize,
+                              const std::string& mapFile, UndistortMaps& maps,
+                              UndistortMapFormat format = UndistortMapFormat::Float, int gridStep = kDefaultGridStep);
+
+} // namespace cameracalib
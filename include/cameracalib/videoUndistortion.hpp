@@ -0,0 +1,39 @@
+#pragma once
+
+#include "cameracalib/profiler.hpp"
+#include "cameracalib/tiledRemap.hpp"
+#include "cameracalib/undistortion.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace cameracalib {
+
+class ThreadPool;
+
+struct VideoUndistortOptions {
+    size_t ringSize = 8;          // frame slots circulating between the decode, remap and encode threads
+    std::string fourcc;           // output codec, empty = same as the input
+    RemapKernel remapKernel = RemapKernel::OpenCV;
+    ThreadPool* pool = nullptr;   // splits the tiled remap of each frame, not owned
+};
+
+struct VideoUndistortStats {
+    size_t frames = 0;
+    double seconds = 0.0;
+    double fps = 0.0;
+    TimingStats latency;  // from the start of decoding a frame until it has been encoded
+    double decodeMs = 0.0;  // busy time of each thread
+    double remapMs = 0.0;
+    double encodeMs = 0.0;
+};
+
+// Undistorts a video file into another one. Decoding, remapping and encoding run on three
+// threads that pass a fixed ring of preallocated frame slots around, so no frame buffer is
+// reallocated after the first pass through the ring. The frame size must match maps.imageSize.
+bool undistortVideo(const UndistortMaps& maps, const std::string& inputFile, const std::string& outputFile,
+                    const VideoUndistortOptions& options, VideoUndistortStats& stats);
+
+void printVideoUndistortStats(const VideoUndistortStats& stats);
+
+} // namespace cameracalib
@@ -0,0 +1,74 @@
+#include "cameracalib/boardTracker.hpp"
+#include "cameracalib/profiler.hpp"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <iostream>
+
+namespace cameracalib {
+
+namespace {
+
+// A region this large saves too little over the full frame to be worth a second search
+const double kMaxRegionFraction = 0.6;
+
+// Keeps small boards from getting a region too tight for the subpixel windows
+const int kMinMarginPixels = 24;
+
+} // namespace
+
+TrackingStats& TrackingStats::operator+=(const TrackingStats& other) {
+    frames += other.frames;
+    roiHits += other.roiHits;
+    fullSearches += other.fullSearches;
+    lost += other.lost;
+    return *this;
+}
+
+cv::Rect predictBoardRegion(const std::vector<cv::Point2f>& corners, const cv::Size& imageSize, double margin) {
+    cv::Rect box = cv::boundingRect(corners);
+    int marginX = std::max(kMinMarginPixels, static_cast<int>(box.width * margin));
+    int marginY = std::max(kMinMarginPixels, static_cast<int>(box.height * margin));
+    cv::Rect region(box.x - marginX, box.y - marginY, box.width + 2 * marginX, box.height + 2 * marginY);
+    return region & cv::Rect(0, 0, imageSize.width, imageSize.height);
+}
+
+ImageDetection BoardTracker::detect(const cv::Mat& gray, const cv::Size& checkerboardSize, const DetectionOptions& options) {
+    stats_.frames++;
+
+    if (!gray.empty() && !lastCorners_.empty()) {
+        cv::Rect region = predictBoardRegion(lastCorners_, gray.size(), options.trackMargin);
+        if (region.area() < kMaxRegionFraction * gray.size().area()) {
+            ScopedTimer timer(options.profiler, "track_roi");
+            // gray(region) is a view, so neither search nor refinement copies the frame
+            ImageDetection detection = detectCheckerboardInGray(gray(region), checkerboardSize, options);
+            if (detection.found) {
+                for (cv::Point2f& corner : detection.corners) {
+                    corner.x += static_cast<float>(region.x);
+                    corner.y += static_cast<float>(region.y);
+                }
+                detection.imageSize = gray.size();
+                lastCorners_ = detection.corners;
+                stats_.roiHits++;
+                return detection;
+            }
+        }
+    }
+
+    stats_.fullSearches++;
+    ImageDetection detection = detectCheckerboardInGray(gray, checkerboardSize, options);
+    if (detection.found) {
+        lastCorners_ = detection.corners;
+    } else {
+        lastCorners_.clear();
+        stats_.lost++;
+    }
+    return detection;
+}
+
+void printTrackingStats(const TrackingStats& stats) {
+    std::cout << "Tracking: " << stats.roiHits << " of " << stats.frames << " frame(s) found in the predicted region, "
+              << stats.fullSearches << " full-frame search(es), board lost " << stats.lost << " time(s)" << std::endl;
+}
+
+} // namespace cameracalib
@@ -0,0 +1,524 @@
+#include "cameracalib/calibration.hpp"
+#include "cameracalib/mappedFile.hpp"
+#include "cameracalib/profiler.hpp"
+
+#include <opencv2/calib3d.hpp>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+
+namespace cameracalib {
+
+namespace {
+
+// Fixed-capacity text buffer for the JSON writer; numbers are formatted in place
+class JsonBuffer {
+public:
+    explicit JsonBuffer(size_t capacity) : data_(new char[capacity]), end_(data_.get() + capacity), pos_(data_.get()) {}
+
+    void append(const char* text) {
+        size_t length = std::strlen(text);
+        if (length > static_cast<size_t>(end_ - pos_)) {
+            overflow_ = true;
+            return;
+        }
+        std::memcpy(pos_, text, length);
+        pos_ += length;
+    }
+
+    // Shortest representation that parses back to exactly value
+    template <typename T>
+    void appendNumber(T value) {
+        std::to_chars_result result = std::to_chars(pos_, end_, value);
+        if (result.ec != std::errc()) {
+            overflow_ = true;
+            return;
+        }
+        pos_ = result.ptr;
+    }
+
+    void appendRow(const double* values, int count) {
+        append("[");
+        for (int i = 0; i < count; i++) {
+            appendNumber(values[i]);
+            if (i < count - 1) append(", ");
+        }
+        append("]");
+    }
+
+    bool overflow() const { return overflow_; }
+    const char* data() const { return data_.get(); }
+    size_t size() const { return static_cast<size_t>(pos_ - data_.get()); }
+
+private:
+    std::unique_ptr<char[]> data_;
+    char* end_;
+    char* pos_;
+    bool overflow_ = false;
+};
+
+// Longest shortest-round-trip double ("-2.2250738585072014e-308") plus separators
+const size_t kMaxNumberChars = 32;
+
+// The elements of values as doubles; read in place when they already are, otherwise
+// converted into scratch, whose buffer is reused for every matrix of the same shape
+const double* doubleElements(const cv::Mat& values, cv::Mat& scratch) {
+    if (values.depth() == CV_64F && values.isContinuous()) {
+        return values.ptr<double>();
+    }
+    values.convertTo(scratch, CV_64F);
+    return scratch.ptr<double>();
+}
+
+} // namespace
+
+bool saveCalibrationResultsToJSON(const CalibrationResults& results, const std::string& outputFile) {
+    cv::Mat scratch;
+    const double zeros[9] = {};
+    const double* cameraMatrix = results.cameraMatrix.total() == 9 ? doubleElements(results.cameraMatrix, scratch) : zeros;
+    int numDistCoeffs = static_cast<int>(results.distCoeffs.total() * results.distCoeffs.channels());
+
+    // Every byte of the file is accounted for up front, so formatting allocates nothing but
+    // the scratch matrix for vectors that are not continuous doubles
+    size_t numbers = 9 + numDistCoeffs + 3 * (results.rvecs.size() + results.tvecs.size()) + 6;
+    JsonBuffer json(512 + kMaxNumberChars * numbers + 16 * (results.rvecs.size() + results.tvecs.size()));
+
+    json.append("{\n");
+    json.append("  \"camera_matrix\": [\n");
+    for (int i = 0; i < 3; i++) {
+        json.append("    ");
+        json.appendRow(cameraMatrix + 3 * i, 3);
+        json.append(i < 2 ? ",\n" : "\n");
+    }
+    json.append("  ],\n");
+
+    json.append("  \"distortion_coefficients\": ");
+    json.appendRow(numDistCoeffs > 0 ? doubleElements(results.distCoeffs, scratch) : nullptr, numDistCoeffs);
+    json.append(",\n");
+
+    const char* vectorKeys[2] = {"  \"rotation_vectors\": [\n", "  \"translation_vectors\": [\n"};
+    const std::vector<cv::Mat>* vectorLists[2] = {&results.rvecs, &results.tvecs};
+    for (int k = 0; k < 2; k++) {
+        json.append(vectorKeys[k]);
+        const std::vector<cv::Mat>& vectors = *vectorLists[k];
+        for (size_t i = 0; i < vectors.size(); i++) {
+            json.append("    ");
+            if (vectors[i].total() * vectors[i].channels() == 3) {
+                json.appendRow(doubleElements(vectors[i], scratch), 3);
+            } else {
+                json.appendRow(zeros, 3);
+            }
+            json.append(i + 1 < vectors.size() ? ",\n" : "\n");
+        }
+        json.append("  ],\n");
+    }
+
+    json.append("  \"calibration_success\": ");
+    json.append(results.success ? "true" : "false");
+    json.append(",\n  \"image_dimensions_wh\": [");
+    json.appendNumber(results.imageSize.width);
+    json.append(", ");
+    json.appendNumber(results.imageSize.height);
+    json.append("],\n  \"checkerboard_dimensions_wh\": [");
+    json.appendNumber(results.checkerboardSize.width);
+    json.append(", ");
+    json.appendNumber(results.checkerboardSize.height);
+    json.append("],\n  \"num_images_used\": ");
+    json.appendNumber(results.numImagesUsed);
+    json.append(",\n  \"mean_reprojection_error\": ");
+    json.appendNumber(results.meanReprojectionError);
+    json.append("\n}\n");
+
+    if (json.overflow()) {
+        std::cerr << "Error: Calibration results for " << outputFile << " exceed the output buffer" << std::endl;
+        return false;
+    }
+
+    // Unbuffered, so the whole document goes out in a single write
+    std::string tempPath = outputFile + ".tmp";
+    std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Error: Could not write to output file " << outputFile << std::endl;
+        return false;
+    }
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    bool written = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+    written = std::fclose(file) == 0 && written;
+    std::error_code renameError;
+    if (written) {
+        std::filesystem::rename(tempPath, outputFile, renameError);
+    }
+    if (!written || renameError) {
+        std::remove(tempPath.c_str());
+        std::cerr << "Error: Could not write to output file " << outputFile << std::endl;
+        return false;
+    }
+
+    std::cout << "\nCalibration results successfully saved to: " << outputFile << std::endl;
+    return true;
+}
+
+namespace {
+
+// Minimal reader for the JSON written by saveCalibrationResultsToJSON: parses numbers in
+// place with std::from_chars and skips values of keys it does not know
+class JsonReader {
+public:
+    JsonReader(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+    bool failed() const { return !error_.empty(); }
+    const std::string& error() const { return error_; }
+
+    void fail(const std::string& message) {
+        if (error_.empty()) {
+            error_ = message;
+        }
+        p_ = end_;
+    }
+
+    void skipSpace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+            p_++;
+        }
+    }
+
+    // Consumes c if it is the next non-space character
+    bool consume(char c) {
+        skipSpace();
+        if (p_ < end_ && *p_ == c) {
+            p_++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            fail(std::string("expected '") + c + "'");
+        }
+    }
+
+    bool atEnd() {
+        skipSpace();
+        return p_ >= end_;
+    }
+
+    std::string readString() {
+        expect('"');
+        const char* start = p_;
+        while (p_ < end_ && *p_ != '"') {
+            p_ += *p_ == '\\' ? 2 : 1;
+        }
+        if (p_ >= end_) {
+            fail("unterminated string");
+            return std::string();
+        }
+        return std::string(start, p_++);
+    }
+
+    double readNumber() {
+        skipSpace();
+        double value = 0.0;
+        // from_chars does not accept the leading '+' that JSON does not allow either
+        std::from_chars_result result = std::from_chars(p_, end_, value);
+        if (result.ec != std::errc()) {
+            fail("expected a number");
+            return 0.0;
+        }
+        p_ = result.ptr;
+        return value;
+    }
+
+    bool readBool() {
+        skipSpace();
+        if (end_ - p_ >= 4 && std::strncmp(p_, "true", 4) == 0) {
+            p_ += 4;
+            return true;
+        }
+        if (end_ - p_ >= 5 && std::strncmp(p_, "false", 5) == 0) {
+            p_ += 5;
+            return false;
+        }
+        fail("expected true or false");
+        return false;
+    }
+
+    void readNumberArray(std::vector<double>& values) {
+        values.clear();
+        expect('[');
+        if (consume(']')) {
+            return;
+        }
+        do {
+            values.push_back(readNumber());
+        } while (!failed() && consume(','));
+        expect(']');
+    }
+
+    // Array of number arrays, e.g. the camera matrix or the per-view vectors
+    void readNumberRows(std::vector<std::vector<double>>& rows) {
+        rows.clear();
+        expect('[');
+        if (consume(']')) {
+            return;
+        }
+        do {
+            rows.emplace_back();
+            readNumberArray(rows.back());
+        } while (!failed() && consume(','));
+        expect(']');
+    }
+
+    void skipValue() {
+        skipSpace();
+        if (p_ >= end_) {
+            fail("unexpected end of file");
+        } else if (*p_ == '"') {
+            readString();
+        } else if (*p_ == '[' || *p_ == '{') {
+            char close = *p_ == '[' ? ']' : '}';
+            bool object = *p_ == '{';
+            p_++;
+            if (consume(close)) {
+                return;
+            }
+            do {
+                if (object) {
+                    readString();
+                    expect(':');
+                }
+                skipValue();
+            } while (!failed() && consume(','));
+            expect(close);
+        } else if (*p_ == 't' || *p_ == 'f') {
+            readBool();
+        } else if (end_ - p_ >= 4 && std::strncmp(p_, "null", 4) == 0) {
+            p_ += 4;
+        } else {
+            readNumber();
+        }
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+    std::string error_;
+};
+
+cv::Mat columnVector(const std::vector<double>& values) {
+    cv::Mat column(static_cast<int>(values.size()), 1, CV_64F);
+    for (size_t i = 0; i < values.size(); i++) {
+        column.at<double>(static_cast<int>(i), 0) = values[i];
+    }
+    return column;
+}
+
+bool readVectors(JsonReader& reader, std::vector<cv::Mat>& vectors) {
+    std::vector<std::vector<double>> rows;
+    reader.readNumberRows(rows);
+    vectors.clear();
+    for (const std::vector<double>& row : rows) {
+        if (row.size() != 3) {
+            reader.fail("pose vectors must have 3 elements");
+            return false;
+        }
+        vectors.push_back(columnVector(row));
+    }
+    return !reader.failed();
+}
+
+bool readSize(JsonReader& reader, cv::Size& size) {
+    std::vector<double> values;
+    reader.readNumberArray(values);
+    if (values.size() != 2) {
+        reader.fail("dimensions must be [width, height]");
+        return false;
+    }
+    size = cv::Size(static_cast<int>(values[0]), static_cast<int>(values[1]));
+    return !reader.failed();
+}
+
+} // namespace
+
+bool loadCalibrationResultsFromJSON(const std::string& inputFile, CalibrationResults& results) {
+    MappedFile file;
+    if (!file.open(inputFile)) {
+        std::cerr << "Error: Could not read calibration file " << inputFile << std::endl;
+        return false;
+    }
+
+    const char* begin = reinterpret_cast<const char*>(file.data());
+    JsonReader reader(begin, begin + file.size());
+    CalibrationResults loaded;
+    bool haveSuccess = false;
+
+    reader.expect('{');
+    if (!reader.consume('}')) {
+        do {
+            std::string key = reader.readString();
+            reader.expect(':');
+            if (key == "camera_matrix") {
+                std::vector<std::vector<double>> rows;
+                reader.readNumberRows(rows);
+                if (rows.size() != 3 || rows[0].size() != 3 || rows[1].size() != 3 || rows[2].size() != 3) {
+                    reader.fail("camera_matrix must be 3x3");
+                    break;
+                }
+                loaded.cameraMatrix.create(3, 3, CV_64F);
+                for (int i = 0; i < 3; i++) {
+                    for (int j = 0; j < 3; j++) {
+                        loaded.cameraMatrix.at<double>(i, j) = rows[i][j];
+                    }
+                }
+            } else if (key == "distortion_coefficients") {
+                std::vector<double> values;
+                reader.readNumberArray(values);
+                loaded.distCoeffs = columnVector(values);
+            } else if (key == "rotation_vectors") {
+                readVectors(reader, loaded.rvecs);
+            } else if (key == "translation_vectors") {
+                readVectors(reader, loaded.tvecs);
+            } else if (key == "calibration_success") {
+                loaded.success = reader.readBool();
+                haveSuccess = true;
+            } else if (key == "image_dimensions_wh") {
+                readSize(reader, loaded.imageSize);
+            } else if (key == "checkerboard_dimensions_wh") {
+                readSize(reader, loaded.checkerboardSize);
+            } else if (key == "num_images_used") {
+                loaded.numImagesUsed = static_cast<int>(reader.readNumber());
+            } else if (key == "mean_reprojection_error") {
+                loaded.meanReprojectionError = reader.readNumber();
+            } else {
+                reader.skipValue();
+            }
+        } while (!reader.failed() && reader.consume(','));
+        reader.expect('}');
+    }
+    if (!reader.failed() && !reader.atEnd()) {
+        reader.fail("unexpected data after the closing brace");
+    }
+
+    if (!reader.failed()) {
+        if (loaded.cameraMatrix.empty()) {
+            reader.fail("camera_matrix is missing");
+        } else if (loaded.distCoeffs.empty()) {
+            reader.fail("distortion_coefficients are missing");
+        } else if (loaded.imageSize.width <= 0 || loaded.imageSize.height <= 0) {
+            reader.fail("image_dimensions_wh are missing");
+        } else if (loaded.rvecs.size() != loaded.tvecs.size()) {
+            reader.fail("rotation_vectors and translation_vectors differ in length");
+        }
+    }
+    if (reader.failed()) {
+        std::cerr << "Error: " << inputFile << " is not a valid calibration file: " << reader.error() << std::endl;
+        return false;
+    }
+
+    // Files without the flag hold a usable calibration if they hold a camera matrix at all
+    if (!haveSuccess) {
+        loaded.success = true;
+    }
+    results = loaded;
+    return true;
+}
+
+std::vector<cv::Point3f> checkerboardObjectPoints(const cv::Size& checkerboardSize) {
+    std::vector<cv::Point3f> objp;
+    for (int i = 0; i < checkerboardSize.height; i++) {
+        for (int j = 0; j < checkerboardSize.width; j++) {
+            objp.push_back(cv::Point3f(j, i, 0));
+        }
+    }
+    return objp;
+}
+
+double meanReprojectionError(const CornerSet& corners, const CalibrationResults& results) {
+    if (corners.imgpoints.empty()) {
+        return 0.0;
+    }
+
+    std::vector<cv::Point3f> objp = checkerboardObjectPoints(corners.checkerboardSize);
+    double totalError = 0.0;
+    for (size_t i = 0; i < corners.imgpoints.size(); i++) {
+        std::vector<cv::Point2f> imgpoints2;
+        cv::projectPoints(objp, results.rvecs[i], results.tvecs[i], 
+                         results.cameraMatrix, results.distCoeffs, imgpoints2);
+        double error = cv::norm(corners.imgpoints[i], imgpoints2, cv::NORM_L2) / imgpoints2.size();
+        totalError += error;
+    }
+    return totalError / corners.imgpoints.size();
+}
+
+CalibrationResults solveCalibration(const CornerSet& corners, Profiler* profiler, const CalibrationResults* initialGuess) {
+    const cv::Size& checkerboardSize = corners.checkerboardSize;
+
+    CalibrationResults results;
+    results.checkerboardSize = checkerboardSize;
+    results.success = false;
+    results.numImagesUsed = 0;
+    results.meanReprojectionError = 0.0;
+
+    if (corners.imgpoints.empty()) {
+        std::cerr << "Error: No checkerboard corners available. Calibration cannot proceed." << std::endl;
+        return results;
+    }
+
+    // Defining the world coordinates for 3D points
+    std::vector<cv::Point3f> objp = checkerboardObjectPoints(checkerboardSize);
+
+    // Creating vector to store vectors of 3D points for each checkerboard image
+    std::vector<std::vector<cv::Point3f>> objpoints(corners.imgpoints.size(), objp);
+    // Creating vector to store vectors of 2D points for each checkerboard image
+    const std::vector<std::vector<cv::Point2f>>& imgpoints = corners.imgpoints;
+    const cv::Size& imageSize = corners.imageSize;
+
+    std::cout << "\nPerforming camera calibration with " << objpoints.size() << " image(s) where corners were found..." << std::endl;
+
+    // Starting from a previous solution of the same camera lets the optimizer skip the
+    // closed-form initialization and converge in fewer iterations
+    int flags = 0;
+    if (initialGuess && !initialGuess->cameraMatrix.empty() && !initialGuess->distCoeffs.empty()) {
+        if (initialGuess->imageSize == imageSize) {
+            initialGuess->cameraMatrix.convertTo(results.cameraMatrix, CV_64F);
+            initialGuess->distCoeffs.convertTo(results.distCoeffs, CV_64F);
+            flags |= cv::CALIB_USE_INTRINSIC_GUESS;
+            std::cout << "Starting from the previous camera matrix and distortion coefficients." << std::endl;
+        } else {
+            std::cerr << "Warning: The previous calibration is for " << initialGuess->imageSize.width << "x"
+                      << initialGuess->imageSize.height << " images, not " << imageSize.width << "x" << imageSize.height
+                      << "; solving from scratch." << std::endl;
+        }
+    }
+
+    ScopedTimer calibrateTimer(profiler, "calibrate_camera");
+    results.success = cv::calibrateCamera(objpoints, imgpoints, imageSize, 
+                                        results.cameraMatrix, results.distCoeffs, 
+                                        results.rvecs, results.tvecs, flags);
+    calibrateTimer.stop();
+
+    if (!results.success) {
+        std::cerr << "Error: Camera calibration failed." << std::endl;
+        return results;
+    }
+
+    results.imageSize = imageSize;
+    results.numImagesUsed = objpoints.size();
+
+    std::cout << "\nCalibration successful!" << std::endl;
+    std::cout << "Camera matrix:" << std::endl << results.cameraMatrix << std::endl;
+    std::cout << "\nDistortion coefficients:" << std::endl << results.distCoeffs << std::endl;
+
+    // Calculate mean reprojection error
+    ScopedTimer reprojectionTimer(profiler, "reprojection");
+    results.meanReprojectionError = meanReprojectionError(corners, results);
+    reprojectionTimer.stop();
+    std::cout << "\nTotal (Mean) Reprojection Error: " << results.meanReprojectionError << std::endl;
+
+    return results;
+}
+
+} // namespace cameracalib
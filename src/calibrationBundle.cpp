@@ -0,0 +1,213 @@
+#include "cameracalib/calibrationBundle.hpp"
+#include "cameracalib/mappedFile.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace cameracalib {
+
+namespace {
+
+// Bundle layout (host byte order): CalibrationBundleHeader, distortion coefficients,
+// rotation vectors and translation vectors as doubles, then padding to a multiple of
+// kMapsAlignment and, optionally, the undistortion maps exactly as in a map file. Every
+// section is addressed by the header alone, so a reader needs no parsing beyond it.
+struct CalibrationBundleHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    int32_t imageWidth;
+    int32_t imageHeight;
+    int32_t boardWidth;
+    int32_t boardHeight;
+    int32_t numImagesUsed;
+    int32_t success;
+    int32_t numDistCoeffs;
+    int32_t numViews;
+    double meanReprojectionError;
+    uint64_t fingerprint;  // calibrationFingerprint for the image size
+    uint64_t mapsOffset;   // 0 if no maps are embedded
+    uint64_t mapsBytes;
+    double cameraMatrix[9];
+};
+
+static_assert(sizeof(CalibrationBundleHeader) == 152, "unexpected calibration bundle header layout");
+
+const char kCalibrationBundleMagic[8] = {'C', 'C', 'C', 'A', 'L', 'I', 'B', '1'};
+const uint32_t kCalibrationBundleVersion = 1;
+
+// Alignment of the start of the embedded map section. The maps themselves follow their
+// 144-byte header and are 16-byte aligned; rows are not padded.
+const size_t kMapsAlignment = 64;
+
+size_t parameterBytes(int numDistCoeffs, int numViews) {
+    return sizeof(double) * (static_cast<size_t>(numDistCoeffs) + 6 * static_cast<size_t>(numViews));
+}
+
+void writeDoubles(std::ostream& out, const cv::Mat& mat, size_t count) {
+    cv::Mat values;
+    mat.convertTo(values, CV_64F);
+    values = values.reshape(1, 1);
+    out.write(reinterpret_cast<const char*>(values.ptr<double>(0)), sizeof(double) * count);
+}
+
+cv::Mat readDoubles(const uchar*& data, int rows) {
+    cv::Mat values(rows, 1, CV_64F);
+    std::memcpy(values.ptr<double>(0), data, sizeof(double) * rows);
+    data += sizeof(double) * rows;
+    return values;
+}
+
+} // namespace
+
+bool isCalibrationBundle(const std::string& file) {
+    std::ifstream in(file, std::ios::binary);
+    char magic[sizeof(kCalibrationBundleMagic)];
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, kCalibrationBundleMagic, sizeof(magic)) == 0;
+}
+
+bool saveCalibrationBundle(const CalibrationResults& results, const UndistortMaps* maps, const std::string& bundleFile) {
+    // Every section has a fixed size derived from the header, so a short record would shift
+    // everything after it; the loader also needs at least one distortion coefficient
+    bool complete = results.cameraMatrix.total() == 9 && results.rvecs.size() == results.tvecs.size() &&
+                    !results.distCoeffs.empty() && results.distCoeffs.channels() == 1;
+    for (const std::vector<cv::Mat>* vectors : {&results.rvecs, &results.tvecs}) {
+        for (const cv::Mat& vector : *vectors) {
+            complete = complete && vector.total() * vector.channels() == 3;
+        }
+    }
+    if (!complete) {
+        std::cerr << "Error: Cannot write calibration bundle " << bundleFile << ": incomplete calibration" << std::endl;
+        return false;
+    }
+
+    uint64_t fingerprint = calibrationFingerprint(results, results.imageSize);
+    bool embedMaps = maps && !maps->empty() && maps->fingerprint == fingerprint;
+    if (maps && !maps->empty() && !embedMaps) {
+        std::cerr << "Warning: Undistortion maps do not match the calibration and are left out of " << bundleFile << std::endl;
+    }
+
+    CalibrationBundleHeader header = {};
+    std::memcpy(header.magic, kCalibrationBundleMagic, sizeof(header.magic));
+    header.version = kCalibrationBundleVersion;
+    header.byteOrderMark = kByteOrderMark;
+    header.imageWidth = results.imageSize.width;
+    header.imageHeight = results.imageSize.height;
+    header.boardWidth = results.checkerboardSize.width;
+    header.boardHeight = results.checkerboardSize.height;
+    header.numImagesUsed = results.numImagesUsed;
+    header.success = results.success ? 1 : 0;
+    header.numDistCoeffs = static_cast<int32_t>(results.distCoeffs.total());
+    header.numViews = static_cast<int32_t>(results.rvecs.size());
+    header.meanReprojectionError = results.meanReprojectionError;
+    header.fingerprint = fingerprint;
+    cv::Mat cameraMatrix;
+    results.cameraMatrix.convertTo(cameraMatrix, CV_64F);
+    std::memcpy(header.cameraMatrix, cameraMatrix.ptr<double>(0), sizeof(header.cameraMatrix));
+
+    size_t parametersEnd = sizeof(header) + parameterBytes(header.numDistCoeffs, header.numViews);
+    if (embedMaps) {
+        header.mapsOffset = (parametersEnd + kMapsAlignment - 1) / kMapsAlignment * kMapsAlignment;
+        header.mapsBytes = undistortMapsBytes(*maps);
+    }
+
+    std::string tempPath = bundleFile + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write to calibration bundle " << bundleFile << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeDoubles(file, results.distCoeffs, header.numDistCoeffs);
+    for (const std::vector<cv::Mat>* vectors : {&results.rvecs, &results.tvecs}) {
+        for (const cv::Mat& vector : *vectors) {
+            writeDoubles(file, vector, 3);
+        }
+    }
+    if (embedMaps) {
+        std::vector<char> padding(header.mapsOffset - parametersEnd, 0);
+        file.write(padding.data(), padding.size());
+        writeUndistortMaps(file, *maps);
+    }
+
+    file.close();
+    std::error_code renameError;
+    if (file) {
+        std::filesystem::rename(tempPath, bundleFile, renameError);
+    }
+    if (!file || renameError) {
+        std::remove(tempPath.c_str());
+        std::cerr << "Error: Could not write to calibration bundle " << bundleFile << std::endl;
+        return false;
+    }
+    std::cout << "Calibration bundle saved to: " << bundleFile << (embedMaps ? " (with undistortion maps)" : "") << std::endl;
+    return true;
+}
+
+bool loadCalibrationBundle(const std::string& bundleFile, CalibrationResults& results, UndistortMaps* maps) {
+    std::shared_ptr<MappedFile> storage(new MappedFile());
+    if (!storage->open(bundleFile)) {
+        std::cerr << "Error: Could not read calibration bundle " << bundleFile << std::endl;
+        return false;
+    }
+
+    // The parameters must fit the file and end before the embedded maps begin
+    CalibrationBundleHeader header;
+    bool valid = storage->size() >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, storage->data(), sizeof(header));
+        valid = std::memcmp(header.magic, kCalibrationBundleMagic, sizeof(header.magic)) == 0 &&
+                header.version == kCalibrationBundleVersion && header.byteOrderMark == kByteOrderMark &&
+                header.imageWidth > 0 && header.imageHeight > 0 && header.numDistCoeffs > 0 && header.numViews >= 0;
+    }
+    if (valid) {
+        size_t parametersEnd = sizeof(header) + parameterBytes(header.numDistCoeffs, header.numViews);
+        valid = parametersEnd <= storage->size() &&
+                (header.mapsOffset == 0 || (header.mapsOffset % kMapsAlignment == 0 && parametersEnd <= header.mapsOffset &&
+                                            header.mapsOffset <= storage->size() &&
+                                            header.mapsBytes == storage->size() - header.mapsOffset));
+    }
+    if (!valid) {
+        std::cerr << "Error: " << bundleFile << " is not a valid calibration bundle" << std::endl;
+        return false;
+    }
+
+    CalibrationResults loaded;
+    loaded.cameraMatrix = cv::Mat(3, 3, CV_64F, header.cameraMatrix).clone();
+    const uchar* data = storage->data() + sizeof(header);
+    loaded.distCoeffs = readDoubles(data, header.numDistCoeffs);
+    for (int i = 0; i < header.numViews; i++) {
+        loaded.rvecs.push_back(readDoubles(data, 3));
+    }
+    for (int i = 0; i < header.numViews; i++) {
+        loaded.tvecs.push_back(readDoubles(data, 3));
+    }
+    loaded.success = header.success != 0;
+    loaded.imageSize = cv::Size(header.imageWidth, header.imageHeight);
+    loaded.checkerboardSize = cv::Size(header.boardWidth, header.boardHeight);
+    loaded.numImagesUsed = header.numImagesUsed;
+    loaded.meanReprojectionError = header.meanReprojectionError;
+
+    if (calibrationFingerprint(loaded, loaded.imageSize) != header.fingerprint) {
+        std::cerr << "Error: " << bundleFile << " is not a valid calibration bundle" << std::endl;
+        return false;
+    }
+
+    if (maps) {
+        *maps = UndistortMaps();
+        if (header.mapsOffset != 0 && !viewUndistortMaps(storage, header.mapsOffset, header.mapsBytes, header.fingerprint, *maps)) {
+            std::cerr << "Warning: Ignoring the damaged undistortion maps in " << bundleFile << std::endl;
+            *maps = UndistortMaps();
+        }
+    }
+    results = loaded;
+    return true;
+}
+
+} // namespace cameracalib
@@ -0,0 +1,183 @@
+#include "cameracalib/commandLine.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace cameracalib {
+
+bool parseDetectionArgument(int argc, char* argv[], int& i, DetectionOptions& options) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if ((arg == "-j" || arg == "--jobs") && hasValue) {
+        options.numJobs = std::stoi(argv[++i]);
+    } else if (arg == "--pipeline") {
+        options.pipeline = true;
+    } else if (arg == "--queue-depth" && hasValue) {
+        options.queueDepth = std::stoul(argv[++i]);
+    } else if (arg == "--pipeline-workers" && hasValue) {
+        options.pipeline = true;
+        std::stringstream workers(argv[++i]);
+        std::string count;
+        options.stageWorkers.clear();
+        while (std::getline(workers, count, ',')) {
+            options.stageWorkers.push_back(std::stoi(count));
+        }
+    } else if (arg == "--pipeline-stats") {
+        options.pipelineStats = true;
+    } else if (arg == "--corner-cache" && hasValue) {
+        options.cornerCachePath = argv[++i];
+    } else if (arg == "--decode" && hasValue) {
+        std::string mode = argv[++i];
+        if (!parseDecodeMode(mode, options.decodeMode)) {
+            throw std::invalid_argument("unknown decode mode " + mode);
+        }
+    } else if (arg == "--pyramid") {
+        options.pyramid = true;
+    } else if (arg == "--pyramid-scale" && hasValue) {
+        options.pyramid = true;
+        options.pyramidScale = std::stod(argv[++i]);
+    } else if (arg == "--detector" && hasValue) {
+        std::string backend = argv[++i];
+        if (!parseDetectorBackend(backend, options.detector)) {
+            throw std::invalid_argument("unknown detector " + backend);
+        }
+    } else if (arg == "--detector-trial" && hasValue) {
+        options.detectorTrialImages = std::stoul(argv[++i]);
+    } else if (arg == "--track") {
+        options.track = true;
+    } else if (arg == "--track-margin" && hasValue) {
+        options.track = true;
+        options.trackMargin = std::stod(argv[++i]);
+    } else if (arg == "--prefilter") {
+        options.prefilter.enabled = true;
+    } else if (arg == "--prefilter-contrast" && hasValue) {
+        options.prefilter.enabled = true;
+        options.prefilter.minContrast = std::stod(argv[++i]);
+    } else if (arg == "--prefilter-sharpness" && hasValue) {
+        options.prefilter.enabled = true;
+        options.prefilter.minSharpness = std::stod(argv[++i]);
+    } else if (arg == "--prefilter-saddles" && hasValue) {
+        options.prefilter.enabled = true;
+        options.prefilter.minSaddleFraction = std::stod(argv[++i]);
+    } else if (arg == "--prefilter-audit" && hasValue) {
+        options.prefilter.enabled = true;
+        options.prefilter.auditFraction = std::stod(argv[++i]);
+    } else if (arg == "--converge") {
+        options.convergence.enabled = true;
+    } else if (arg == "--converge-batch" && hasValue) {
+        options.convergence.enabled = true;
+        options.convergence.batchSize = std::stoul(argv[++i]);
+        if (options.convergence.batchSize == 0) {
+            throw std::invalid_argument("must be at least 1");
+        }
+    } else if (arg == "--converge-min-views" && hasValue) {
+        options.convergence.enabled = true;
+        options.convergence.minViews = std::stoul(argv[++i]);
+    } else if (arg == "--converge-intrinsics" && hasValue) {
+        options.convergence.enabled = true;
+        options.convergence.intrinsicsTolerance = std::stod(argv[++i]);
+    } else if (arg == "--converge-distortion" && hasValue) {
+        options.convergence.enabled = true;
+        options.convergence.distortionTolerance = std::stod(argv[++i]);
+    } else if (arg == "--converge-error" && hasValue) {
+        options.convergence.enabled = true;
+        options.convergence.errorTolerance = std::stod(argv[++i]);
+    } else if (arg == "--converge-checks" && hasValue) {
+        options.convergence.enabled = true;
+        options.convergence.stableChecks = std::stoi(argv[++i]);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int parseIntValue(const std::string& text, int minimum) {
+    size_t end = 0;
+    int value = 0;
+    try {
+        value = std::stoi(text, &end);
+    } catch (const std::exception&) {
+        end = 0;
+    }
+    if (end == 0 || end != text.size()) {
+        throw std::invalid_argument("expected an integer, got '" + text + "'");
+    }
+    if (value < minimum) {
+        throw std::invalid_argument("must be at least " + std::to_string(minimum));
+    }
+    return value;
+}
+
+size_t parseCountValue(const std::string& text, size_t minimum) {
+    // std::stoull accepts a sign and wraps negative values around
+    size_t end = 0;
+    unsigned long long value = 0;
+    if (!text.empty() && text[0] >= '0' && text[0] <= '9') {
+        try {
+            value = std::stoull(text, &end);
+        } catch (const std::exception&) {
+            end = 0;
+        }
+    }
+    if (end == 0 || end != text.size()) {
+        throw std::invalid_argument("expected a non-negative integer, got '" + text + "'");
+    }
+    if (value < minimum) {
+        throw std::invalid_argument("must be at least " + std::to_string(minimum));
+    }
+    return static_cast<size_t>(value);
+}
+
+double parseDoubleValue(const std::string& text, double minimum) {
+    size_t end = 0;
+    double value = 0.0;
+    try {
+        value = std::stod(text, &end);
+    } catch (const std::exception&) {
+        end = 0;
+    }
+    if (end == 0 || end != text.size()) {
+        throw std::invalid_argument("expected a number, got '" + text + "'");
+    }
+    // Also rejects NaN
+    if (!(value >= minimum)) {
+        std::ostringstream message;
+        message << "must be at least " << minimum;
+        throw std::invalid_argument(message.str());
+    }
+    return value;
+}
+
+void printDetectionUsage() {
+    std::cout << "  -j, --jobs <n>               Number of worker threads for corner detection, 0 = all cores (default: 1)\n";
+    std::cout << "  --pipeline                   Run read/decode/gray/detect/refine as overlapping pipeline stages\n";
+    std::cout << "  --queue-depth <n>            Maximum number of images waiting between two pipeline stages (default: 8)\n";
+    std::cout << "  --pipeline-workers <r,d,g,f,s> Worker threads per pipeline stage (default: 1,jobs/2,1,jobs,1)\n";
+    std::cout << "  --pipeline-stats             Print pipeline stage occupancy and queue depths\n";
+    std::cout << "  --corner-cache <file>        Reuse detected corners from (and store new ones in) this cache file\n";
+    std::cout << "  --decode <mode>              Image decode for detection: color, gray, reduced2, reduced4 (default: color)\n";
+    std::cout << "  --pyramid                    Search for the board on a downscaled image and refine at full resolution\n";
+    std::cout << "  --pyramid-scale <f>          Downscale factor for --pyramid, 0 = chosen from image and board size (default: 0)\n";
+    std::cout << "  --detector <classic|sb|auto> Board detector: findChessboardCorners + cornerSubPix, findChessboardCornersSB, or\n";
+    std::cout << "                               the faster adequate one after a trial on the first images (default: classic)\n";
+    std::cout << "  --detector-trial <n>         Images the detectors are compared on with --detector auto (default: 5)\n";
+    std::cout << "  --track                      For video input, search each frame near the last board position first\n";
+    std::cout << "  --track-margin <f>           Grow the tracked region by this fraction of the board size per side (default: 0.25)\n";
+    std::cout << "  --prefilter                  Skip the board search on images whose thumbnail statistics rule out a board\n";
+    std::cout << "  --prefilter-contrast <v>     Minimum gray-level standard deviation for --prefilter (default: 10)\n";
+    std::cout << "  --prefilter-sharpness <v>    Minimum Laplacian variance for --prefilter (default: 10)\n";
+    std::cout << "  --prefilter-saddles <f>      Minimum saddle points per inner board corner for --prefilter (default: 0.5)\n";
+    std::cout << "  --prefilter-audit <f>        Search this share of rejected images anyway to measure false rejects (default: 0)\n";
+    std::cout << "  --converge                   Stop reading images once trial solves on the views so far agree\n";
+    std::cout << "  --converge-batch <n>         Images detected between two trial solves (default: 16)\n";
+    std::cout << "  --converge-min-views <n>     Views needed before the first trial solve (default: 10)\n";
+    std::cout << "  --converge-intrinsics <f>    Largest relative change of fx, fy, cx, cy between trial solves (default: 0.005)\n";
+    std::cout << "  --converge-distortion <v>    Largest change of k1, k2, p1, p2 between trial solves (default: 0.01)\n";
+    std::cout << "  --converge-error <px>        Largest change of the RMS reprojection error between trial solves (default: 0.02)\n";
+    std::cout << "  --converge-checks <n>        Consecutive trial solves within all tolerances needed to stop (default: 2)\n";
+}
+
+} // namespace cameracalib
@@ -0,0 +1,135 @@
+#include "cameracalib/convergence.hpp"
+
+#include <opencv2/calib3d.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace cameracalib {
+
+namespace {
+
+// Only the leading coefficients are compared; k3 and higher trade off against k1 and k2
+// and keep moving long after the lens model has settled
+const int kComparedDistortionCoeffs = 4;
+
+// Fewer views leave cv::calibrateCamera underdetermined or badly conditioned
+const size_t kMinTrialViews = 3;
+
+} // namespace
+
+bool ConvergenceMonitor::update(const CornerSet& corners, size_t imagesRead) {
+    size_t views = corners.imgpoints.size();
+    if (views < std::max(options_.minViews, kMinTrialViews)) {
+        return false;
+    }
+
+    ConvergenceCheck check;
+    check.imagesRead = imagesRead;
+    check.views = views;
+
+    std::vector<std::vector<cv::Point3f>> objpoints(views, checkerboardObjectPoints(corners.checkerboardSize));
+    cv::Mat cameraMatrix = cameraMatrix_.clone();
+    cv::Mat distCoeffs = distCoeffs_.clone();
+    int flags = cameraMatrix.empty() ? 0 : cv::CALIB_USE_INTRINSIC_GUESS;
+    std::vector<cv::Mat> rvecs, tvecs;
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+        check.rms = cv::calibrateCamera(objpoints, corners.imgpoints, corners.imageSize, cameraMatrix, distCoeffs,
+                                        rvecs, tvecs, flags);
+    } catch (const cv::Exception& e) {
+        std::cerr << "Warning: Trial solve on " << views << " view(s) failed: " << e.what() << std::endl;
+        cameraMatrix_.release();
+        distCoeffs_.release();
+        stableRun_ = 0;
+        return false;
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    check.solveMs = elapsed.count();
+
+    if (!cameraMatrix_.empty()) {
+        check.compared = true;
+        const double fx = cameraMatrix_.at<double>(0, 0);
+        const double fy = cameraMatrix_.at<double>(1, 1);
+        const double scales[4] = {fx, fy, fx, fy};
+        const int rows[4] = {0, 1, 0, 1};
+        const int cols[4] = {0, 1, 2, 2};
+        for (int k = 0; k < 4; k++) {
+            double change = std::abs(cameraMatrix.at<double>(rows[k], cols[k]) - cameraMatrix_.at<double>(rows[k], cols[k]));
+            check.intrinsicsChange = std::max(check.intrinsicsChange, change / std::abs(scales[k]));
+        }
+        int coeffs = std::min<int>(kComparedDistortionCoeffs, static_cast<int>(std::min(distCoeffs.total(), distCoeffs_.total())));
+        for (int k = 0; k < coeffs; k++) {
+            double change = std::abs(distCoeffs.at<double>(k) - distCoeffs_.at<double>(k));
+            check.distortionChange = std::max(check.distortionChange, change);
+        }
+        check.errorChange = std::abs(check.rms - rms_);
+        check.stable = check.intrinsicsChange <= options_.intrinsicsTolerance &&
+                       check.distortionChange <= options_.distortionTolerance &&
+                       check.errorChange <= options_.errorTolerance;
+    }
+
+    stableRun_ = check.stable ? stableRun_ + 1 : 0;
+    cameraMatrix_ = cameraMatrix;
+    distCoeffs_ = distCoeffs;
+    rms_ = check.rms;
+    checks_.push_back(check);
+
+    std::cout << "Trial solve on " << views << " view(s) after " << imagesRead << " image(s): RMS " << check.rms << " px";
+    if (check.compared) {
+        std::cout << ", intrinsics change " << 100.0 * check.intrinsicsChange << "%, distortion change "
+                  << check.distortionChange << ", error change " << check.errorChange << " px"
+                  << (check.stable ? " (stable)" : "");
+    }
+    std::cout << std::endl;
+
+    return converged();
+}
+
+bool ConvergenceMonitor::converged() const {
+    return stableRun_ >= std::max(1, options_.stableChecks);
+}
+
+std::vector<size_t> interleavedOrder(size_t count) {
+    int bits = 0;
+    while ((size_t(1) << bits) < count) {
+        bits++;
+    }
+
+    std::vector<size_t> order;
+    order.reserve(count);
+    for (size_t i = 0; i < (size_t(1) << bits); i++) {
+        size_t reversed = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (size_t(1) << b)) {
+                reversed |= size_t(1) << (bits - 1 - b);
+            }
+        }
+        if (reversed < count) {
+            order.push_back(reversed);
+        }
+    }
+    return order;
+}
+
+void printConvergenceStats(const ConvergenceStats& stats) {
+    if (!stats.converged) {
+        std::cout << "Convergence: not reached, detected all " << stats.imagesTotal << " image(s); "
+                  << stats.trialSolves << " trial solve(s) took " << stats.solveMs << " ms" << std::endl;
+        return;
+    }
+
+    std::cout << "Convergence: stopped after " << stats.imagesRead << " of " << stats.imagesTotal << " image(s) ("
+              << stats.views << " view(s), " << stats.trialSolves << " trial solve(s))" << std::endl;
+
+    // Detection time per image so far is what every image left unread would have cost
+    size_t skipped = stats.imagesTotal - stats.imagesRead;
+    double meanDetectMs = stats.imagesRead > 0 ? stats.detectMs / stats.imagesRead : 0.0;
+    std::cout << "  Estimated time saved: " << skipped * meanDetectMs - stats.solveMs << " ms (" << skipped
+              << " skipped image(s) of " << meanDetectMs << " ms each, minus " << stats.solveMs << " ms of trial solves)"
+              << std::endl;
+}
+
+} // namespace cameracalib
@@ -0,0 +1,230 @@
+#include "cameracalib/cornerCache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace cameracalib {
+
+namespace {
+
+// Corner cache file layout (host byte order, every record 8-byte aligned so the file can be
+// used in place after mmap): CornerCacheHeader, entryCount CornerCacheEntry records, then
+// the float x/y pairs of all found boards, referenced by cornerOffset (counted in points).
+struct CornerCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t entryCount;
+    uint64_t pointCount;
+};
+
+struct CornerCacheEntry {
+    uint64_t contentHash;
+    uint64_t fileSize;
+    int64_t modifiedTime;
+    int32_t boardWidth;
+    int32_t boardHeight;
+    uint32_t detectionFlags;
+    uint32_t found;
+    int32_t imageWidth;
+    int32_t imageHeight;
+    uint32_t cornerCount;
+    uint32_t reserved;
+    uint64_t cornerOffset;
+};
+
+static_assert(sizeof(CornerCacheHeader) == 32, "unexpected corner cache header layout");
+static_assert(sizeof(CornerCacheEntry) == 64, "unexpected corner cache entry layout");
+
+const char kCornerCacheMagic[8] = {'C', 'C', 'C', 'O', 'R', 'N', 'E', 'R'};
+const uint32_t kCornerCacheVersion = 1;
+
+} // namespace
+
+uint64_t hashBytes(const uchar* data, size_t size) {
+    const uint64_t prime = 0x9E3779B97F4A7C15ULL;
+    uint64_t hash = prime ^ (size * 0xC2B2AE3D27D4EB4FULL);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        word *= 0xC2B2AE3D27D4EB4FULL;
+        word = (word << 31) | (word >> 33);
+        hash ^= word * prime;
+        hash = ((hash << 27) | (hash >> 37)) * 5 + 0x52DCE729;
+    }
+    for (; i < size; i++) {
+        hash ^= data[i] * 0x165667B19E3779F9ULL;
+        hash = ((hash << 11) | (hash >> 53)) * prime;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+
+bool CornerCache::load(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.clear();
+    entries_.clear();
+    ownedCorners_.clear();
+    dirty_ = false;
+    if (!mapped_.open(path)) {
+        return false;
+    }
+    if (mapped_.size() < sizeof(CornerCacheHeader)) {
+        mapped_.close();
+        return false;
+    }
+
+    CornerCacheHeader header;
+    std::memcpy(&header, mapped_.data(), sizeof(header));
+    size_t entriesBytes = header.entryCount * sizeof(CornerCacheEntry);
+    size_t pointsBytes = header.pointCount * sizeof(cv::Point2f);
+    if (std::memcmp(header.magic, kCornerCacheMagic, sizeof(header.magic)) != 0 || header.version != kCornerCacheVersion ||
+        header.byteOrderMark != kByteOrderMark || mapped_.size() != sizeof(header) + entriesBytes + pointsBytes) {
+        mapped_.close();
+        return false;
+    }
+
+    const CornerCacheEntry* records = reinterpret_cast<const CornerCacheEntry*>(mapped_.data() + sizeof(header));
+    const cv::Point2f* points = reinterpret_cast<const cv::Point2f*>(mapped_.data() + sizeof(header) + entriesBytes);
+    for (size_t i = 0; i < header.entryCount; i++) {
+        const CornerCacheEntry& record = records[i];
+        if (record.cornerOffset + record.cornerCount > header.pointCount) {
+            continue;
+        }
+        Entry entry;
+        entry.key.contentHash = record.contentHash;
+        entry.key.fileSize = record.fileSize;
+        entry.key.modifiedTime = record.modifiedTime;
+        entry.key.boardWidth = record.boardWidth;
+        entry.key.boardHeight = record.boardHeight;
+        entry.key.detectionFlags = record.detectionFlags;
+        entry.found = record.found != 0;
+        entry.imageSize = cv::Size(record.imageWidth, record.imageHeight);
+        entry.corners = points + record.cornerOffset;
+        entry.cornerCount = record.cornerCount;
+        index_[entry.key] = entries_.size();
+        entries_.push_back(entry);
+    }
+    return true;
+}
+
+bool CornerCache::save(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string tempPath = path + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    CornerCacheHeader header;
+    std::memcpy(header.magic, kCornerCacheMagic, sizeof(header.magic));
+    header.version = kCornerCacheVersion;
+    header.byteOrderMark = kByteOrderMark;
+    header.entryCount = entries_.size();
+    header.pointCount = 0;
+    for (const Entry& entry : entries_) {
+        header.pointCount += entry.cornerCount;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    uint64_t cornerOffset = 0;
+    for (const Entry& entry : entries_) {
+        CornerCacheEntry record = {};
+        record.contentHash = entry.key.contentHash;
+        record.fileSize = entry.key.fileSize;
+        record.modifiedTime = entry.key.modifiedTime;
+        record.boardWidth = entry.key.boardWidth;
+        record.boardHeight = entry.key.boardHeight;
+        record.detectionFlags = entry.key.detectionFlags;
+        record.found = entry.found ? 1 : 0;
+        record.imageWidth = entry.imageSize.width;
+        record.imageHeight = entry.imageSize.height;
+        record.cornerCount = static_cast<uint32_t>(entry.cornerCount);
+        record.cornerOffset = cornerOffset;
+        cornerOffset += entry.cornerCount;
+        file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    for (const Entry& entry : entries_) {
+        file.write(reinterpret_cast<const char*>(entry.corners), entry.cornerCount * sizeof(cv::Point2f));
+    }
+
+    file.close();
+    if (!file) {
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        return false;
+    }
+    dirty_ = false;
+    return true;
+}
+
+bool CornerCache::makeKey(const std::string& imagePath, const std::vector<uchar>& fileData, const cv::Size& checkerboardSize,
+                          uint32_t detectionFlags, CornerCacheKey& key) {
+    std::error_code error;
+    auto modifiedTime = std::filesystem::last_write_time(imagePath, error);
+    if (error || fileData.empty()) {
+        return false;
+    }
+    key.contentHash = hashBytes(fileData.data(), fileData.size());
+    key.fileSize = fileData.size();
+    key.modifiedTime = static_cast<int64_t>(modifiedTime.time_since_epoch().count());
+    key.boardWidth = checkerboardSize.width;
+    key.boardHeight = checkerboardSize.height;
+    key.detectionFlags = detectionFlags;
+    return true;
+}
+
+bool CornerCache::lookup(const CornerCacheKey& key, ImageDetection& detection) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        misses_++;
+        return false;
+    }
+    const Entry& entry = entries_[it->second];
+    detection.imageRead = true;
+    detection.found = entry.found;
+    detection.imageSize = entry.imageSize;
+    detection.corners.assign(entry.corners, entry.corners + entry.cornerCount);
+    hits_++;
+    return true;
+}
+
+void CornerCache::store(const CornerCacheKey& key, const ImageDetection& detection) {
+    // A prefilter rejection depends on its thresholds, which are not part of the key, and
+    // is cheap to repeat; only results of a full board search are kept
+    if (!detection.imageRead || (detection.prefilter.rejected && !detection.prefilter.audited)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_ptr<std::vector<cv::Point2f>> corners(new std::vector<cv::Point2f>(detection.corners));
+
+    Entry entry;
+    entry.key = key;
+    entry.found = detection.found;
+    entry.imageSize = detection.imageSize;
+    entry.corners = corners->data();
+    entry.cornerCount = corners->size();
+    ownedCorners_.push_back(std::move(corners));
+
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        entries_[it->second] = entry;
+    } else {
+        index_[key] = entries_.size();
+        entries_.push_back(entry);
+    }
+    dirty_ = true;
+}
+
+} // namespace cameracalib
@@ -0,0 +1,114 @@
+#include "cameracalib/cornerFile.hpp"
+#include "cameracalib/mappedFile.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace cameracalib {
+
+namespace {
+
+// Corner file layout (host byte order): CornerFileHeader followed by viewCount records of
+// a uint32 name length, the name bytes and checkerboard width * height float x/y pairs
+struct CornerFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    int32_t imageWidth;
+    int32_t imageHeight;
+    int32_t boardWidth;
+    int32_t boardHeight;
+    uint64_t viewCount;
+};
+
+const char kCornerFileMagic[8] = {'C', 'C', 'P', 'O', 'I', 'N', 'T', 'S'};
+const uint32_t kCornerFileVersion = 1;
+
+} // namespace
+
+bool saveCornerFile(const CornerSet& corners, const std::string& outputFile) {
+    std::ofstream file(outputFile, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write to corner file " << outputFile << std::endl;
+        return false;
+    }
+
+    CornerFileHeader header;
+    std::memcpy(header.magic, kCornerFileMagic, sizeof(header.magic));
+    header.version = kCornerFileVersion;
+    header.byteOrderMark = kByteOrderMark;
+    header.imageWidth = corners.imageSize.width;
+    header.imageHeight = corners.imageSize.height;
+    header.boardWidth = corners.checkerboardSize.width;
+    header.boardHeight = corners.checkerboardSize.height;
+    header.viewCount = corners.imgpoints.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (size_t i = 0; i < corners.imgpoints.size(); i++) {
+        const std::string& name = corners.viewNames[i];
+        uint32_t nameLength = static_cast<uint32_t>(name.size());
+        file.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+        file.write(name.data(), nameLength);
+        file.write(reinterpret_cast<const char*>(corners.imgpoints[i].data()), corners.imgpoints[i].size() * sizeof(cv::Point2f));
+    }
+
+    file.close();
+    if (!file) {
+        std::cerr << "Error: Could not write to corner file " << outputFile << std::endl;
+        return false;
+    }
+    std::cout << "\nCorners of " << corners.imgpoints.size() << " view(s) saved to: " << outputFile << std::endl;
+    return true;
+}
+
+bool loadCornerFile(const std::string& inputFile, CornerSet& corners) {
+    std::ifstream file(inputFile, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open corner file " << inputFile << std::endl;
+        return false;
+    }
+
+    CornerFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kCornerFileMagic, sizeof(header.magic)) != 0 ||
+        header.version != kCornerFileVersion || header.byteOrderMark != kByteOrderMark ||
+        header.boardWidth <= 0 || header.boardHeight <= 0) {
+        std::cerr << "Error: " << inputFile << " is not a valid corner file." << std::endl;
+        return false;
+    }
+
+    cv::Size imageSize(header.imageWidth, header.imageHeight);
+    cv::Size checkerboardSize(header.boardWidth, header.boardHeight);
+    if (corners.imgpoints.empty() && corners.imageSize.area() == 0) {
+        corners.imageSize = imageSize;
+        corners.checkerboardSize = checkerboardSize;
+    } else if (corners.imageSize != imageSize || corners.checkerboardSize != checkerboardSize) {
+        std::cerr << "Error: Corner file " << inputFile << " was detected with a different image or checkerboard size." << std::endl;
+        return false;
+    }
+
+    size_t pointsPerView = static_cast<size_t>(checkerboardSize.area());
+    for (uint64_t v = 0; v < header.viewCount; v++) {
+        uint32_t nameLength = 0;
+        if (!file.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength)) || nameLength > 4096) {
+            std::cerr << "Error: Corner file " << inputFile << " is truncated." << std::endl;
+            return false;
+        }
+        std::string name(nameLength, '\0');
+        std::vector<cv::Point2f> points(pointsPerView);
+        if (!file.read(&name[0], nameLength) ||
+            !file.read(reinterpret_cast<char*>(points.data()), pointsPerView * sizeof(cv::Point2f))) {
+            std::cerr << "Error: Corner file " << inputFile << " is truncated." << std::endl;
+            return false;
+        }
+        corners.viewNames.push_back(name);
+        corners.imgpoints.push_back(points);
+    }
+
+    std::cout << "Loaded " << header.viewCount << " view(s) from corner file " << inputFile << std::endl;
+    return true;
+}
+
+} // namespace cameracalib
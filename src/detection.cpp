@@ -0,0 +1,437 @@
+#include "cameracalib/detection.hpp"
+#include "cameracalib/cornerCache.hpp"
+#include "cameracalib/mappedFile.hpp"
+#include "cameracalib/profiler.hpp"
+#include "cameracalib/threadPool.hpp"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace cameracalib {
+
+const int kChessboardFlags = cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_FAST_CHECK | cv::CALIB_CB_NORMALIZE_IMAGE;
+const int kChessboardSBFlags = cv::CALIB_CB_NORMALIZE_IMAGE | cv::CALIB_CB_ACCURACY;
+
+bool parseDecodeMode(const std::string& name, DecodeMode& mode) {
+    if (name == "color") {
+        mode = DecodeMode::Color;
+    } else if (name == "gray") {
+        mode = DecodeMode::Gray;
+    } else if (name == "reduced2") {
+        mode = DecodeMode::Reduced2;
+    } else if (name == "reduced4") {
+        mode = DecodeMode::Reduced4;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* decodeModeName(DecodeMode mode) {
+    switch (mode) {
+    case DecodeMode::Gray:
+        return "gray";
+    case DecodeMode::Reduced2:
+        return "reduced2";
+    case DecodeMode::Reduced4:
+        return "reduced4";
+    default:
+        return "color";
+    }
+}
+
+bool parseDetectorBackend(const std::string& name, DetectorBackend& backend) {
+    if (name == "classic") {
+        backend = DetectorBackend::Classic;
+    } else if (name == "sb") {
+        backend = DetectorBackend::SectorBased;
+    } else if (name == "auto") {
+        backend = DetectorBackend::Auto;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* detectorBackendName(DetectorBackend backend) {
+    switch (backend) {
+    case DetectorBackend::SectorBased:
+        return "sb";
+    case DetectorBackend::Auto:
+        return "auto";
+    default:
+        return "classic";
+    }
+}
+
+int decodeModeScale(DecodeMode mode) {
+    switch (mode) {
+    case DecodeMode::Reduced2:
+        return 2;
+    case DecodeMode::Reduced4:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+cv::Mat decodeSearchImage(const std::vector<uchar>& fileData, DecodeMode mode, Profiler* profiler) {
+    cv::Mat gray;
+    if (fileData.empty()) {
+        return gray;
+    }
+
+    ScopedTimer decodeTimer(profiler, "decode");
+    switch (mode) {
+    case DecodeMode::Color:
+        {
+            cv::Mat frame = cv::imdecode(fileData, cv::IMREAD_COLOR);
+            decodeTimer.stop();
+            if (!frame.empty()) {
+                ScopedTimer convertTimer(profiler, "cvt_color");
+                cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+            }
+        }
+        break;
+    case DecodeMode::Gray:
+        gray = cv::imdecode(fileData, cv::IMREAD_GRAYSCALE);
+        break;
+    case DecodeMode::Reduced2:
+        gray = cv::imdecode(fileData, cv::IMREAD_REDUCED_GRAYSCALE_2);
+        break;
+    case DecodeMode::Reduced4:
+        gray = cv::imdecode(fileData, cv::IMREAD_REDUCED_GRAYSCALE_4);
+        break;
+    }
+    return gray;
+}
+
+uint32_t detectionCacheFlags(const DetectionOptions& options) {
+    uint32_t flags = static_cast<uint32_t>(kChessboardFlags) | (static_cast<uint32_t>(options.decodeMode) << 16);
+    if (options.pyramid) {
+        // Explicit scales are keyed in quarter steps, 0 stands for the automatic choice
+        uint32_t scaleKey = static_cast<uint32_t>(std::min(127L, std::lround(options.pyramidScale * 4)));
+        flags |= (1u << 20) | (scaleKey << 21);
+    }
+    if (options.detector == DetectorBackend::SectorBased) {
+        flags |= 1u << 29;
+    }
+    return flags;
+}
+
+int resolveNumJobs(int numJobs) {
+    if (numJobs <= 0) {
+        return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    return numJobs;
+}
+
+std::vector<cv::String> findCalibrationImages(const std::string& imageDir) {
+    // Extracting path of individual image stored in a given directory
+    std::vector<cv::String> images;
+    std::vector<std::string> patterns = {"*.jpg", "*.jpeg", "*.png", "*.bmp", "*.tiff"};
+    
+    for (const auto& pattern : patterns) {
+        std::vector<cv::String> temp;
+        cv::glob(imageDir + "/" + pattern, temp);
+        images.insert(images.end(), temp.begin(), temp.end());
+    }
+
+    return images;
+}
+
+std::vector<cv::String> findInputImages(const std::string& dirOrList) {
+    if (std::filesystem::is_directory(dirOrList)) {
+        return findCalibrationImages(dirOrList);
+    }
+
+    std::vector<cv::String> images;
+    std::ifstream list(dirOrList);
+    std::string line;
+    while (std::getline(list, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty() && line[0] != '#') {
+            images.push_back(line);
+        }
+    }
+    return images;
+}
+
+bool findCheckerboardCorners(const cv::Mat& gray, const cv::Size& checkerboardSize, std::vector<cv::Point2f>& corners,
+                             Profiler* profiler, DetectorBackend backend) {
+    ScopedTimer timer(profiler, "find_corners");
+    if (backend == DetectorBackend::SectorBased) {
+        bool found = cv::findChessboardCornersSB(gray, checkerboardSize, corners, kChessboardSBFlags);
+        timer.stop(found ? "find_corners_sb_found" : "find_corners_sb_not_found");
+        return found;
+    }
+    bool found = cv::findChessboardCorners(gray, checkerboardSize, corners, kChessboardFlags);
+    timer.stop(found ? "find_corners_found" : "find_corners_not_found");
+    return found;
+}
+
+bool searchCheckerboard(const cv::Mat& search, const cv::Size& checkerboardSize, ImageDetection& detection,
+                        const DetectionOptions& options) {
+    const PrefilterOptions& prefilter = options.prefilter;
+    detection.prefilter = PrefilterOutcome();
+    if (prefilter.enabled) {
+        auto filterStart = std::chrono::steady_clock::now();
+        PrefilterScores scores = computePrefilterScores(search, prefilter);
+        bool accepted = prefilterAccepts(scores, checkerboardSize, prefilter);
+        std::chrono::duration<double, std::milli> filterTime = std::chrono::steady_clock::now() - filterStart;
+        detection.prefilter.filterMs = filterTime.count();
+        if (options.profiler) {
+            options.profiler->record("prefilter", filterTime.count());
+        }
+
+        if (!accepted) {
+            detection.prefilter.rejected = true;
+            if (!prefilterAuditSelects(scores, prefilter.auditFraction)) {
+                detection.corners.clear();
+                return false;
+            }
+            detection.prefilter.audited = true;
+        }
+    }
+
+    auto searchStart = std::chrono::steady_clock::now();
+    bool found = findCheckerboardCorners(search, checkerboardSize, detection.corners, options.profiler, options.detector);
+    if (detection.prefilter.audited) {
+        // A board found by the audit is kept; the rejection only counts as a false one
+        std::chrono::duration<double, std::milli> searchTime = std::chrono::steady_clock::now() - searchStart;
+        detection.prefilter.auditMs = searchTime.count();
+        detection.prefilter.auditFound = found;
+    }
+    return found;
+}
+
+void refineCheckerboardCorners(const cv::Mat& gray, std::vector<cv::Point2f>& corners) {
+    cv::TermCriteria criteria(cv::TermCriteria::EPS | cv::TermCriteria::MAX_ITER, 30, 0.001);
+    cv::cornerSubPix(gray, corners, cv::Size(11, 11), cv::Size(-1, -1), criteria);
+}
+
+void refineScaledCorners(const cv::Mat& gray, double scaleX, double scaleY, std::vector<cv::Point2f>& corners) {
+    // Pixel centers of the reduced image sit at (x + 0.5) * scale - 0.5 in the full one
+    for (cv::Point2f& corner : corners) {
+        corner.x = static_cast<float>((corner.x + 0.5) * scaleX - 0.5);
+        corner.y = static_cast<float>((corner.y + 0.5) * scaleY - 0.5);
+    }
+
+    // The upscaled estimates can be off by about one reduced pixel, so widen the
+    // search window first when that exceeds the regular 11 pixel half-window
+    int halfWindow = static_cast<int>(std::ceil(3 * std::max(scaleX, scaleY)));
+    if (halfWindow > 11) {
+        cv::TermCriteria criteria(cv::TermCriteria::EPS | cv::TermCriteria::MAX_ITER, 10, 0.01);
+        cv::cornerSubPix(gray, corners, cv::Size(halfWindow, halfWindow), cv::Size(-1, -1), criteria);
+    }
+    refineCheckerboardCorners(gray, corners);
+}
+
+double pyramidSearchScale(const cv::Size& imageSize, const cv::Size& checkerboardSize) {
+    const double minBoardFraction = 1.0 / 3.0;  // smallest board extent relative to the shorter side
+    const double minSquarePixels = 12.0;        // below this findChessboardCorners gets unreliable
+    const double minSearchSide = 480.0;         // never search on less than this
+
+    double shorterSide = std::min(imageSize.width, imageSize.height);
+    int squaresAcross = std::max(checkerboardSize.width, checkerboardSize.height) + 1;
+    double squarePixels = shorterSide * minBoardFraction / squaresAcross;
+
+    double scale = std::min(squarePixels / minSquarePixels, shorterSide / minSearchSide);
+    return std::max(1.0, scale);
+}
+
+cv::Mat makeSearchImage(const cv::Mat& gray, int decodeScale, const cv::Size& checkerboardSize, const DetectionOptions& options) {
+    if (!options.pyramid || gray.empty()) {
+        return gray;
+    }
+
+    // The scale is chosen for the full image, part of it may already be done by the decoder
+    double scale = options.pyramidScale > 0
+        ? options.pyramidScale
+        : pyramidSearchScale(cv::Size(gray.cols * decodeScale, gray.rows * decodeScale), checkerboardSize);
+    double remaining = scale / decodeScale;
+    if (remaining < 1.25) {
+        return gray;
+    }
+
+    ScopedTimer timer(options.profiler, "downscale");
+    cv::Mat search;
+    cv::Size searchSize(std::max(1, cvRound(gray.cols / remaining)), std::max(1, cvRound(gray.rows / remaining)));
+    cv::resize(gray, search, searchSize, 0, 0, cv::INTER_AREA);
+    return search;
+}
+
+void refineSearchCorners(const cv::Mat& fullGray, const cv::Mat& search, std::vector<cv::Point2f>& corners,
+                         Profiler* profiler, DetectorBackend backend) {
+    bool fullResolution = search.cols == fullGray.cols && search.rows == fullGray.rows;
+    if (fullResolution && backend == DetectorBackend::SectorBased) {
+        return;
+    }
+
+    ScopedTimer timer(profiler, "corner_subpix");
+    if (fullResolution) {
+        refineCheckerboardCorners(fullGray, corners);
+    } else {
+        refineScaledCorners(fullGray, static_cast<double>(fullGray.cols) / search.cols,
+                            static_cast<double>(fullGray.rows) / search.rows, corners);
+    }
+}
+
+ImageDetection detectCheckerboardInGray(const cv::Mat& gray, const cv::Size& checkerboardSize, const DetectionOptions& options) {
+    ImageDetection detection;
+
+    if (gray.empty()) {
+        return detection;
+    }
+
+    detection.imageRead = true;
+    detection.imageSize = cv::Size(gray.cols, gray.rows);
+
+    // Finding checker board corners
+    cv::Mat search = makeSearchImage(gray, 1, checkerboardSize, options);
+    detection.found = searchCheckerboard(search, checkerboardSize, detection, options);
+
+    if (detection.found) {
+        refineSearchCorners(gray, search, detection.corners, options.profiler, options.detector);
+    } else {
+        detection.corners.clear();
+    }
+
+    return detection;
+}
+
+ImageDetection detectCheckerboardInImage(const cv::Mat& frame, const cv::Size& checkerboardSize, const DetectionOptions& options) {
+    if (frame.empty()) {
+        return ImageDetection();
+    }
+
+    cv::Mat gray;
+    {
+        ScopedTimer timer(options.profiler, "cvt_color");
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+    }
+    return detectCheckerboardInGray(gray, checkerboardSize, options);
+}
+
+ImageDetection detectCheckerboardInFile(const std::vector<uchar>& fileData, const cv::Size& checkerboardSize,
+                                        const DetectionOptions& options) {
+    int decodeScale = decodeModeScale(options.decodeMode);
+    cv::Mat gray = decodeSearchImage(fileData, options.decodeMode, options.profiler);
+    if (decodeScale == 1) {
+        return detectCheckerboardInGray(gray, checkerboardSize, options);
+    }
+
+    ImageDetection detection;
+    if (gray.empty()) {
+        return detection;
+    }
+
+    detection.imageRead = true;
+
+    // Finding checker board corners on the reduced decode
+    cv::Mat search = makeSearchImage(gray, decodeScale, checkerboardSize, options);
+    detection.found = searchCheckerboard(search, checkerboardSize, detection, options);
+
+    if (!detection.found) {
+        detection.corners.clear();
+        return detection;
+    }
+
+    ScopedTimer decodeTimer(options.profiler, "decode_full");
+    cv::Mat fullGray = cv::imdecode(fileData, cv::IMREAD_GRAYSCALE);
+    decodeTimer.stop();
+    if (fullGray.empty()) {
+        detection.found = false;
+        detection.corners.clear();
+        return detection;
+    }
+    detection.imageSize = cv::Size(fullGray.cols, fullGray.rows);
+    refineSearchCorners(fullGray, search, detection.corners, options.profiler, options.detector);
+
+    return detection;
+}
+
+ImageDetection detectCheckerboard(const std::string& imagePath, const cv::Size& checkerboardSize, const DetectionOptions& options,
+                                  CornerCache* cache, std::vector<uchar>& fileBuffer) {
+    ImageDetection detection;
+    ScopedTimer readTimer(options.profiler, "read");
+    if (!readFileBytes(imagePath, fileBuffer)) {
+        return detection;
+    }
+    readTimer.stop();
+
+    // The file has been read anyway, so hash it and decode from the same bytes on a miss
+    ScopedTimer cacheTimer(cache ? options.profiler : nullptr, "cache_lookup");
+    CornerCacheKey key;
+    bool haveKey = cache && CornerCache::makeKey(imagePath, fileBuffer, checkerboardSize, detectionCacheFlags(options), key);
+    if (haveKey && cache->lookup(key, detection)) {
+        detection.fromCache = true;
+        return detection;
+    }
+    cacheTimer.stop();
+
+    detection = detectCheckerboardInFile(fileBuffer, checkerboardSize, options);
+    if (haveKey) {
+        cache->store(key, detection);
+    }
+    return detection;
+}
+
+void logDetection(const ImageDetection& detection, const std::string& imagePath) {
+    std::string filename = std::filesystem::path(imagePath).filename().string();
+    if (!detection.imageRead) {
+        std::cout << "Warning: Could not read image " << imagePath << ". Skipping." << std::endl;
+    } else if (detection.found) {
+        std::cout << "  -> Checkerboard found and corners refined for \"" << filename << "\""
+                  << (detection.fromCache ? " (cached)" : "") << std::endl;
+    } else {
+        std::cout << "  -> Checkerboard not found in \"" << filename << "\""
+                  << (detection.fromCache ? " (cached)" : "") << std::endl;
+    }
+}
+
+std::vector<ImageDetection> detectCheckerboards(const std::vector<cv::String>& images, const cv::Size& checkerboardSize,
+                                                const DetectionOptions& options, ThreadPool& pool, CornerCache* cache,
+                                                std::vector<std::vector<uchar>>& fileBuffers) {
+    std::vector<ImageDetection> detections(images.size());
+    if (fileBuffers.size() < static_cast<size_t>(pool.size())) {
+        fileBuffers.resize(pool.size());
+    }
+
+    std::mutex logMutex;
+
+    // Each worker claims the next unprocessed image until none are left
+    pool.parallelFor(images.size(), [&](size_t i, int worker) {
+        {
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cout << "Processing image " << (i + 1) << "/" << images.size() << ": \""
+                      << std::filesystem::path(images[i]).filename().string() << "\"..." << std::endl;
+        }
+
+        try {
+            detections[i] = detectCheckerboard(images[i], checkerboardSize, options, cache, fileBuffers[worker]);
+        } catch (const cv::Exception& e) {
+            detections[i] = ImageDetection();
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cout << "Warning: OpenCV error while processing " << images[i] << ": " << e.what() << std::endl;
+        }
+
+        std::lock_guard<std::mutex> lock(logMutex);
+        logDetection(detections[i], images[i]);
+    });
+
+    return detections;
+}
+
+} // namespace cameracalib
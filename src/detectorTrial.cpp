@@ -0,0 +1,110 @@
+#include "cameracalib/detectorTrial.hpp"
+#include "cameracalib/calibration.hpp"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace cameracalib {
+
+namespace {
+
+// Accuracy differences below this are not worth a slower detector
+const double kAccuracyToleranceRms = 0.25;
+
+} // namespace
+
+double cornerHomographyRms(const std::vector<cv::Point2f>& corners, const cv::Size& checkerboardSize) {
+    std::vector<cv::Point2f> board;
+    for (const cv::Point3f& p : checkerboardObjectPoints(checkerboardSize)) {
+        board.push_back(cv::Point2f(p.x, p.y));
+    }
+    if (corners.size() != board.size() || board.size() < 4) {
+        return 0.0;
+    }
+
+    cv::Mat H = cv::findHomography(board, corners);
+    if (H.empty()) {
+        return 0.0;
+    }
+    std::vector<cv::Point2f> projected;
+    cv::perspectiveTransform(board, projected, H);
+
+    double sum = 0.0;
+    for (size_t i = 0; i < corners.size(); i++) {
+        cv::Point2f d = projected[i] - corners[i];
+        sum += d.x * d.x + d.y * d.y;
+    }
+    return std::sqrt(sum / corners.size());
+}
+
+std::vector<DetectorTrial> runDetectorTrials(const std::vector<cv::Mat>& grays, const cv::Size& checkerboardSize,
+                                             const DetectionOptions& options) {
+    // Only the detector itself is measured
+    DetectionOptions trialOptions = options;
+    trialOptions.prefilter.enabled = false;
+    trialOptions.profiler = nullptr;
+
+    std::vector<DetectorTrial> trials;
+    for (DetectorBackend backend : {DetectorBackend::Classic, DetectorBackend::SectorBased}) {
+        DetectorTrial trial;
+        trial.backend = backend;
+        trialOptions.detector = backend;
+
+        double totalMs = 0.0;
+        double squaredResidual = 0.0;
+        for (const cv::Mat& gray : grays) {
+            auto start = std::chrono::steady_clock::now();
+            ImageDetection detection = detectCheckerboardInGray(gray, checkerboardSize, trialOptions);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            totalMs += elapsed.count();
+
+            trial.images++;
+            if (detection.found) {
+                trial.found++;
+                double rms = cornerHomographyRms(detection.corners, checkerboardSize);
+                squaredResidual += rms * rms;
+            }
+        }
+        trial.meanMs = trial.images > 0 ? totalMs / trial.images : 0.0;
+        trial.homographyRms = trial.found > 0 ? std::sqrt(squaredResidual / trial.found) : 0.0;
+        trials.push_back(trial);
+    }
+    return trials;
+}
+
+DetectorBackend chooseDetectorBackend(const std::vector<DetectorTrial>& trials) {
+    size_t mostFound = 0;
+    double bestRms = 0.0;
+    bool haveRms = false;
+    for (const DetectorTrial& trial : trials) {
+        mostFound = std::max(mostFound, trial.found);
+    }
+    for (const DetectorTrial& trial : trials) {
+        if (trial.found == mostFound && trial.found > 0 && (!haveRms || trial.homographyRms < bestRms)) {
+            bestRms = trial.homographyRms;
+            haveRms = true;
+        }
+    }
+
+    const DetectorTrial* best = nullptr;
+    for (const DetectorTrial& trial : trials) {
+        bool adequate = trial.found == mostFound && (!haveRms || trial.homographyRms <= bestRms + kAccuracyToleranceRms);
+        if (adequate && (!best || trial.meanMs < best->meanMs)) {
+            best = &trial;
+        }
+    }
+    return best ? best->backend : DetectorBackend::Classic;
+}
+
+void printDetectorTrials(const std::vector<DetectorTrial>& trials) {
+    for (const DetectorTrial& trial : trials) {
+        std::cout << "  " << detectorBackendName(trial.backend) << ": found " << trial.found << "/" << trial.images << ", "
+                  << trial.meanMs << " ms per image, homography RMS " << trial.homographyRms << " px" << std::endl;
+    }
+}
+
+} // namespace cameracalib
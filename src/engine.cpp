@@ -0,0 +1,619 @@
+#include "cameracalib/engine.hpp"
+#include "cameracalib/boardTracker.hpp"
+#include "cameracalib/boundedQueue.hpp"
+#include "cameracalib/cornerCache.hpp"
+#include "cameracalib/detectorTrial.hpp"
+#include "cameracalib/mappedFile.hpp"
+#include "cameracalib/profiler.hpp"
+#include "cameracalib/threadPool.hpp"
+#include "cameracalib/undistortion.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace cameracalib {
+
+CalibrationEngine::CalibrationEngine(const DetectionOptions& options)
+    : options_(options), pool_(new ThreadPool(resolveNumJobs(options.numJobs))) {
+    fileBuffers_.resize(pool_->size());
+}
+
+CalibrationEngine::~CalibrationEngine() = default;
+
+CornerCache* CalibrationEngine::cornerCache() {
+    if (options_.cornerCachePath.empty()) {
+        return nullptr;
+    }
+    if (!cacheLoaded_) {
+        cache_.reset(new CornerCache());
+        if (cache_->load(options_.cornerCachePath)) {
+            std::cout << "Loaded corner cache " << options_.cornerCachePath << " (" << cache_->size() << " entries)" << std::endl;
+        }
+        cacheLoaded_ = true;
+    }
+    return cache_.get();
+}
+
+ThreadPool& CalibrationEngine::stagePool(const DetectionOptions& options) {
+    int threads = pipelineThreadCount(options);
+    if (!stagePool_ || stagePool_->size() < threads) {
+        stagePool_.reset(new ThreadPool(threads));
+    }
+    return *stagePool_;
+}
+
+namespace {
+
+// Adds the corners of every view where the board was found to corners, in the given order
+bool collectCorners(const std::vector<ImageDetection>& detections, const std::vector<std::string>& viewNames, CornerSet& corners) {
+    bool imageSizeSet = false;
+
+    for (size_t i = 0; i < detections.size(); i++) {
+        const ImageDetection& detection = detections[i];
+        if (!detection.imageRead) {
+            continue;
+        }
+
+        // Reduced decodes only know the full size of images where the board was found
+        if (!imageSizeSet && detection.imageSize.area() > 0) {
+            corners.imageSize = detection.imageSize;
+            imageSizeSet = true;
+        }
+
+        if (detection.found) {
+            corners.viewNames.push_back(viewNames[i]);
+            corners.imgpoints.push_back(detection.corners);
+        }
+    }
+
+    if (corners.imgpoints.empty()) {
+        std::cerr << "Error: No checkerboard corners were detected in any of the images. Calibration cannot proceed." << std::endl;
+        return false;
+    }
+
+    if (!imageSizeSet) {
+        std::cerr << "Error: Could not determine image dimensions for calibration." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// Sums the prefilter outcomes of freshly detected views and prints them
+void reportPrefilter(const std::vector<ImageDetection>& detections, const DetectionOptions& options) {
+    if (!options.prefilter.enabled) {
+        return;
+    }
+    PrefilterStats stats;
+    for (const ImageDetection& detection : detections) {
+        if (detection.imageRead && !detection.fromCache) {
+            stats.add(detection.prefilter);
+        }
+    }
+    printPrefilterStats(stats);
+}
+
+// Times both detector backends on sample images and returns the one to use for the job
+DetectorBackend selectDetector(const std::vector<cv::Mat>& grays, const cv::Size& checkerboardSize, const DetectionOptions& options) {
+    if (grays.empty()) {
+        std::cerr << "Warning: No images for the detector trial, using the classic detector." << std::endl;
+        return DetectorBackend::Classic;
+    }
+    std::cout << "Detector trial on " << grays.size() << " image(s):" << std::endl;
+    std::vector<DetectorTrial> trials = runDetectorTrials(grays, checkerboardSize, options);
+    printDetectorTrials(trials);
+    DetectorBackend backend = chooseDetectorBackend(trials);
+    std::cout << "Selected detector: " << detectorBackendName(backend) << std::endl;
+    return backend;
+}
+
+// Consecutive keyframes one worker detects in a row when tracking; only the first of each
+// run is searched as a whole
+const size_t kTrackedRunFrames = 8;
+
+// Asks a thread to stop and joins it when leaving the scope, so that an exception on the
+// owning thread does not destroy a joinable std::thread
+class StoppingJoiner {
+public:
+    StoppingJoiner(std::thread& thread, std::atomic<bool>& stop) : thread_(thread), stop_(stop) {}
+    StoppingJoiner(const StoppingJoiner&) = delete;
+    StoppingJoiner& operator=(const StoppingJoiner&) = delete;
+    ~StoppingJoiner() { join(); }
+
+    void join() {
+        stop_ = true;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    std::thread& thread_;
+    std::atomic<bool>& stop_;
+};
+
+} // namespace
+
+bool CalibrationEngine::detectCorners(const std::string& imageDir, const cv::Size& checkerboardSize, CornerSet& corners) {
+    std::cout << "Image directory: " << imageDir << std::endl;
+
+    ScopedTimer globTimer(options_.profiler, "glob");
+    std::vector<cv::String> images = findCalibrationImages(imageDir);
+    globTimer.stop();
+
+    if (images.empty()) {
+        std::cerr << "Error: No images found in directory '" << imageDir << "' with supported patterns." << std::endl;
+        corners = CornerSet();
+        corners.checkerboardSize = checkerboardSize;
+        return false;
+    }
+
+    // Keeping every shardCount-th image so that detection can be split across machines
+    if (options_.shardCount > 1) {
+        std::vector<cv::String> shard;
+        for (size_t i = options_.shardIndex; i < images.size(); i += options_.shardCount) {
+            shard.push_back(images[i]);
+        }
+        std::cout << "Shard " << options_.shardIndex << "/" << options_.shardCount << ": " << shard.size() << " of "
+                  << images.size() << " images." << std::endl;
+        images.swap(shard);
+    }
+
+    return detectCorners(images, checkerboardSize, corners);
+}
+
+bool CalibrationEngine::detectCorners(const std::vector<cv::String>& images, const cv::Size& checkerboardSize, CornerSet& corners) {
+    std::cout << "Checkerboard size: " << checkerboardSize.width << "x" << checkerboardSize.height << std::endl;
+    std::cout << "Worker threads: " << pool_->size() << (options_.pipeline ? " (pipelined)" : "") << std::endl;
+    std::cout << "Decode mode: " << decodeModeName(options_.decodeMode) << (options_.pyramid ? ", pyramid search" : "") << std::endl;
+    std::cout << "Detector: " << detectorBackendName(options_.detector) << std::endl;
+
+    corners = CornerSet();
+    corners.checkerboardSize = checkerboardSize;
+
+    if (images.empty()) {
+        std::cerr << "Error: No images to process." << std::endl;
+        return false;
+    }
+
+    std::cout << "Found " << images.size() << " images." << std::endl;
+
+    // The automatic choice is made per job, as every job may come from another camera
+    DetectionOptions options = options_;
+    if (options.detector == DetectorBackend::Auto) {
+        std::vector<cv::Mat> sample;
+        for (size_t i = 0; i < images.size() && sample.size() < options.detectorTrialImages; i++) {
+            cv::Mat gray = cv::imread(images[i], cv::IMREAD_GRAYSCALE);
+            if (!gray.empty()) {
+                sample.push_back(gray);
+            }
+        }
+        options.detector = selectDetector(sample, checkerboardSize, options);
+    }
+
+    // Detecting corners on all images, possibly in parallel; results are kept per image
+    // so that imgpoints are merged back in file order below
+    CornerCache* cache = cornerCache();
+    size_t hitsBefore = cache ? cache->hits() : 0;
+    size_t missesBefore = cache ? cache->misses() : 0;
+
+    std::vector<ImageDetection> detections;
+    if (options.convergence.enabled) {
+        detections = detectUntilConverged(images, checkerboardSize, options, cache);
+    } else {
+        detections = options.pipeline ? detectCheckerboardsPipelined(images, checkerboardSize, options, stagePool(options), cache)
+                                      : detectCheckerboards(images, checkerboardSize, options, *pool_, cache, fileBuffers_);
+    }
+
+    if (cache) {
+        std::cout << "Corner cache: " << cache->hits() - hitsBefore << " hit(s), " << cache->misses() - missesBefore
+                  << " miss(es)" << std::endl;
+        if (cache->dirty() && !cache->save(options_.cornerCachePath)) {
+            std::cerr << "Warning: Could not write corner cache " << options_.cornerCachePath << std::endl;
+        }
+    }
+
+    reportPrefilter(detections, options);
+
+    std::vector<std::string> viewNames;
+    viewNames.reserve(images.size());
+    for (const cv::String& image : images) {
+        viewNames.push_back(std::filesystem::path(image).filename().string());
+    }
+    return collectCorners(detections, viewNames, corners);
+}
+
+std::vector<ImageDetection> CalibrationEngine::detectUntilConverged(const std::vector<cv::String>& images,
+                                                                    const cv::Size& checkerboardSize,
+                                                                    const DetectionOptions& options, CornerCache* cache) {
+    const ConvergenceOptions& convergence = options.convergence;
+    size_t batchSize = std::max<size_t>(1, convergence.batchSize);
+    std::cout << "Convergence check every " << batchSize << " image(s)" << std::endl;
+
+    // Unread images keep imageRead == false and are skipped when the corners are collected
+    std::vector<ImageDetection> detections(images.size());
+    std::vector<size_t> order = interleavedOrder(images.size());
+    ConvergenceMonitor monitor(convergence);
+    CornerSet trialCorners;
+    trialCorners.checkerboardSize = checkerboardSize;
+
+    ConvergenceStats stats;
+    stats.imagesTotal = images.size();
+    for (size_t start = 0; start < order.size() && !monitor.converged(); start += batchSize) {
+        size_t end = std::min(order.size(), start + batchSize);
+        std::vector<cv::String> batch;
+        for (size_t k = start; k < end; k++) {
+            batch.push_back(images[order[k]]);
+        }
+
+        auto detectStart = std::chrono::steady_clock::now();
+        std::vector<ImageDetection> batchDetections = options.pipeline
+            ? detectCheckerboardsPipelined(batch, checkerboardSize, options, stagePool(options), cache)
+            : detectCheckerboards(batch, checkerboardSize, options, *pool_, cache, fileBuffers_);
+        std::chrono::duration<double, std::milli> detectTime = std::chrono::steady_clock::now() - detectStart;
+        stats.detectMs += detectTime.count();
+        stats.imagesRead = end;
+
+        for (size_t k = start; k < end; k++) {
+            ImageDetection& detection = batchDetections[k - start];
+            if (detection.found) {
+                if (trialCorners.imgpoints.empty()) {
+                    trialCorners.imageSize = detection.imageSize;
+                }
+                trialCorners.viewNames.push_back(std::filesystem::path(images[order[k]]).filename().string());
+                trialCorners.imgpoints.push_back(detection.corners);
+            }
+            detections[order[k]] = std::move(detection);
+        }
+
+        // After the last batch there is nothing left to save
+        if (end < order.size()) {
+            ScopedTimer timer(options.profiler, "convergence_solve");
+            monitor.update(trialCorners, end);
+        }
+    }
+
+    stats.views = trialCorners.imgpoints.size();
+    stats.converged = monitor.converged();
+    stats.trialSolves = monitor.checks().size();
+    for (const ConvergenceCheck& check : monitor.checks()) {
+        stats.solveMs += check.solveMs;
+    }
+    printConvergenceStats(stats);
+    return detections;
+}
+
+bool CalibrationEngine::detectCornersInVideo(const std::string& videoFile, const cv::Size& checkerboardSize,
+                                             const KeyframeOptions& keyframeOptions, CornerSet& corners) {
+    std::cout << "Video: " << videoFile << std::endl;
+    std::cout << "Checkerboard size: " << checkerboardSize.width << "x" << checkerboardSize.height << std::endl;
+    std::cout << "Worker threads: " << pool_->size() << " (keyframe selection on its own thread)" << std::endl;
+
+    corners = CornerSet();
+    corners.checkerboardSize = checkerboardSize;
+
+    cv::VideoCapture capture(videoFile);
+    if (!capture.isOpened()) {
+        std::cerr << "Error: Could not open video " << videoFile << std::endl;
+        return false;
+    }
+
+    DetectionOptions options = options_;
+    if (options.detector == DetectorBackend::Auto) {
+        // The trial reads its sample through a capture of its own
+        cv::VideoCapture trialCapture(videoFile);
+        std::vector<cv::Mat> sample;
+        cv::Mat frame;
+        int sampleStep = std::max(1, keyframeOptions.sampleStep);
+        for (int frameIndex = 0; sample.size() < options.detectorTrialImages && trialCapture.grab(); frameIndex++) {
+            if (frameIndex % sampleStep == 0 && trialCapture.retrieve(frame) && !frame.empty()) {
+                cv::Mat gray;
+                if (frame.channels() == 1) {
+                    gray = frame.clone();
+                } else {
+                    cv::cvtColor(frame, gray, frame.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+                }
+                sample.push_back(gray);
+            }
+        }
+        options.detector = selectDetector(sample, checkerboardSize, options);
+    }
+
+    // Selection runs ahead of detection: one thread walks the video and queues the accepted
+    // frames while the pool detects boards on them. The queue bounds how many full-resolution
+    // frames are held at once.
+    Profiler* profiler = options.profiler;
+    KeyframeSelector selector(keyframeOptions);
+    BoundedQueue<Keyframe> keyframes(options.queueDepth);
+    std::atomic<bool> selectionDone(false);
+    std::atomic<bool> stopSelection(false);
+    std::string selectionError;
+
+    std::thread selectThread([&]() {
+        try {
+            int sampleStep = std::max(1, keyframeOptions.sampleStep);
+            cv::Mat frame;
+            Keyframe keyframe;
+            for (int frameIndex = 0; !stopSelection; frameIndex++) {
+                if (keyframeOptions.maxFrames > 0 && selector.stats().accepted >= keyframeOptions.maxFrames) {
+                    break;
+                }
+
+                // Skipped frames are grabbed but never retrieved as pixels
+                ScopedTimer readTimer(profiler, "read");
+                if (!capture.grab()) {
+                    break;
+                }
+                selector.stats().framesRead++;
+                if (frameIndex % sampleStep != 0) {
+                    continue;
+                }
+                if (!capture.retrieve(frame) || frame.empty()) {
+                    continue;
+                }
+                readTimer.stop("decode");
+
+                ScopedTimer selectTimer(profiler, "keyframe_select");
+                if (frame.channels() == 1) {
+                    keyframe.gray = frame.clone();
+                } else {
+                    cv::cvtColor(frame, keyframe.gray, frame.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+                }
+                if (!selector.accept(keyframe.gray)) {
+                    continue;
+                }
+                selectTimer.stop();
+
+                keyframe.frameIndex = frameIndex;
+                int attempt = 0;
+                while (!stopSelection && !keyframes.tryPush(keyframe)) {
+                    waitBackoff(attempt);
+                }
+            }
+        } catch (const std::exception& e) {
+            selectionError = e.what();
+        } catch (...) {
+            selectionError = "unknown error";
+        }
+        selectionDone = true;
+    });
+    StoppingJoiner selectJoiner(selectThread, stopSelection);
+
+    // Keyframes leave the queue in frame order. With tracking every worker takes a run of
+    // consecutive ones, so its tracker follows the board from each keyframe to the next;
+    // without it, runs are single frames. Holding the pop lock while a run fills only
+    // delays other workers when selection is the bottleneck anyway.
+    size_t runFrames = options.track ? kTrackedRunFrames : 1;
+    std::vector<BoardTracker> trackers(options.track ? pool_->size() : 0);
+    std::mutex popMutex;
+    std::mutex detectionMutex;
+    std::vector<std::pair<int, ImageDetection>> frameDetections;
+    pool_->parallelFor(pool_->size(), [&](size_t, int worker) {
+        std::vector<Keyframe> run;
+        Keyframe keyframe;
+        for (;;) {
+            run.clear();
+            {
+                std::lock_guard<std::mutex> popLock(popMutex);
+                int attempt = 0;
+                while (run.size() < runFrames) {
+                    // Read before popping, so that a frame queued just before the end is not missed
+                    bool done = selectionDone;
+                    if (keyframes.tryPop(keyframe)) {
+                        run.push_back(std::move(keyframe));
+                        attempt = 0;
+                    } else if (done) {
+                        break;
+                    } else {
+                        waitBackoff(attempt);
+                    }
+                }
+            }
+            if (run.empty()) {
+                break;
+            }
+
+            // The previous run of this worker ended somewhere else in the video
+            if (options.track) {
+                trackers[worker].reset();
+            }
+            for (Keyframe& frame : run) {
+                ImageDetection detection;
+                try {
+                    detection = options.track ? trackers[worker].detect(frame.gray, checkerboardSize, options)
+                                              : detectCheckerboardInGray(frame.gray, checkerboardSize, options);
+                } catch (const cv::Exception& e) {
+                    std::lock_guard<std::mutex> lock(detectionMutex);
+                    std::cerr << "Warning: OpenCV error while processing " << keyframeName(frame.frameIndex) << ": " << e.what() << std::endl;
+                    continue;
+                }
+                frame.gray.release();
+                std::lock_guard<std::mutex> lock(detectionMutex);
+                logDetection(detection, keyframeName(frame.frameIndex));
+                frameDetections.emplace_back(frame.frameIndex, std::move(detection));
+            }
+        }
+    });
+    selectJoiner.join();
+
+    printKeyframeStats(selector.stats());
+    if (options.track) {
+        TrackingStats trackingStats;
+        for (const BoardTracker& tracker : trackers) {
+            trackingStats += tracker.stats();
+        }
+        printTrackingStats(trackingStats);
+    }
+    if (!selectionError.empty()) {
+        std::cerr << "Warning: Reading " << videoFile << " stopped early: " << selectionError << std::endl;
+    }
+
+    // Detection finishes out of order; views are kept in frame order
+    std::sort(frameDetections.begin(), frameDetections.end(),
+              [](const std::pair<int, ImageDetection>& a, const std::pair<int, ImageDetection>& b) { return a.first < b.first; });
+    std::vector<ImageDetection> detections;
+    std::vector<std::string> viewNames;
+    for (std::pair<int, ImageDetection>& frameDetection : frameDetections) {
+        viewNames.push_back(keyframeName(frameDetection.first));
+        detections.push_back(std::move(frameDetection.second));
+    }
+    reportPrefilter(detections, options);
+    return collectCorners(detections, viewNames, corners);
+}
+
+CalibrationResults CalibrationEngine::solve(const CornerSet& corners, const CalibrationResults* initialGuess) {
+    return solveCalibration(corners, options_.profiler, initialGuess);
+}
+
+CalibrationResults CalibrationEngine::calibrate(const std::string& imageDir, const cv::Size& checkerboardSize,
+                                                const CalibrationResults* initialGuess) {
+    std::cout << "Starting camera calibration..." << std::endl;
+
+    CornerSet corners;
+    if (!detectCorners(imageDir, checkerboardSize, corners)) {
+        CalibrationResults results;
+        results.checkerboardSize = checkerboardSize;
+        return results;
+    }
+
+    return solve(corners, initialGuess);
+}
+
+CalibrationResults CalibrationEngine::calibrateVideo(const std::string& videoFile, const cv::Size& checkerboardSize,
+                                                     const KeyframeOptions& keyframeOptions,
+                                                     const CalibrationResults* initialGuess) {
+    std::cout << "Starting camera calibration..." << std::endl;
+
+    CornerSet corners;
+    if (!detectCornersInVideo(videoFile, checkerboardSize, keyframeOptions, corners)) {
+        CalibrationResults results;
+        results.checkerboardSize = checkerboardSize;
+        return results;
+    }
+
+    return solve(corners, initialGuess);
+}
+
+const UndistortMaps& CalibrationEngine::undistortMaps(const CalibrationResults& results, const cv::Size& imageSize) {
+    if (maps_.empty() || maps_.imageSize != imageSize || maps_.format() != mapFormat_ ||
+        (mapFormat_ == UndistortMapFormat::Grid && maps_.gridStep != gridStep_) ||
+        maps_.fingerprint != calibrationFingerprint(results, imageSize)) {
+        ScopedTimer timer(options_.profiler, "undistort_maps");
+        if (!loadOrBuildUndistortMaps(results, imageSize, mapFile_, maps_, mapFormat_, gridStep_)) {
+            std::cerr << "Warning: Undistortion maps are kept in memory only." << std::endl;
+        }
+    }
+    return maps_;
+}
+
+void CalibrationEngine::undistort(const CalibrationResults& results, const cv::Mat& src, cv::Mat& dst) {
+    const UndistortMaps& maps = undistortMaps(results, src.size());
+    ScopedTimer timer(options_.profiler, "remap");
+    remapImage(maps, src, dst, remapKernel_, pool_.get());
+}
+
+size_t CalibrationEngine::undistortFiles(const CalibrationResults& results, const std::vector<cv::String>& images,
+                                         const std::string& outDir) {
+    // Outputs are named after the input file alone, so inputs from different directories
+    // with the same name would overwrite each other
+    std::unordered_map<std::string, size_t> outputNames;
+    for (size_t i = 0; i < images.size(); i++) {
+        auto inserted = outputNames.emplace(std::filesystem::path(images[i]).filename().string(), i);
+        if (!inserted.second) {
+            std::cerr << "Error: " << images[inserted.first->second] << " and " << images[i] << " would both be written to "
+                      << (std::filesystem::path(outDir) / inserted.first->first).string() << "; nothing was undistorted."
+                      << std::endl;
+            return 0;
+        }
+    }
+
+    const UndistortMaps& maps = undistortMaps(results, results.imageSize);
+    Profiler* profiler = options_.profiler;
+
+    std::cout << "Undistorting " << images.size() << " image(s) into " << outDir << " with " << pool_->size()
+              << " worker(s)..." << std::endl;
+    auto start = std::chrono::steady_clock::now();
+
+    std::atomic<size_t> written(0);
+    std::mutex logMutex;
+    pool_->parallelFor(images.size(), [&](size_t i, int worker) {
+        std::string outputPath = (std::filesystem::path(outDir) / std::filesystem::path(images[i]).filename()).string();
+        std::vector<uchar>& fileBuffer = fileBuffers_[worker];
+        try {
+            cv::Mat src;
+            bool read;
+            {
+                ScopedTimer timer(profiler, "read");
+                read = readFileBytes(images[i], fileBuffer);
+            }
+            if (read) {
+                // Unchanged keeps the channel count, bit depth and alpha of the original
+                ScopedTimer timer(profiler, "decode");
+                src = cv::imdecode(fileBuffer, cv::IMREAD_UNCHANGED);
+            }
+            if (src.empty()) {
+                std::lock_guard<std::mutex> lock(logMutex);
+                std::cerr << "Warning: Could not read image " << images[i] << std::endl;
+                return;
+            }
+            if (src.size() != maps.imageSize) {
+                std::lock_guard<std::mutex> lock(logMutex);
+                std::cerr << "Warning: Skipping " << images[i] << ": size " << src.size() << " does not match the calibration ("
+                          << maps.imageSize << ")" << std::endl;
+                return;
+            }
+
+            cv::Mat dst;
+            {
+                // Images are already spread over the pool, so each one is remapped on its worker
+                ScopedTimer timer(profiler, "remap");
+                remapImage(maps, src, dst, remapKernel_);
+            }
+
+            ScopedTimer timer(profiler, "encode");
+            if (!cv::imwrite(outputPath, dst)) {
+                std::lock_guard<std::mutex> lock(logMutex);
+                std::cerr << "Warning: Could not write " << outputPath << std::endl;
+                return;
+            }
+            written++;
+        } catch (const cv::Exception& e) {
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cerr << "Warning: OpenCV error while undistorting " << images[i] << ": " << e.what() << std::endl;
+        }
+    });
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Undistorted " << written << "/" << images.size() << " image(s) in " << elapsed.count() << " s ("
+              << (elapsed.count() > 0.0 ? written / elapsed.count() : 0.0) << " images/s)" << std::endl;
+    return written;
+}
+
+bool CalibrationEngine::undistortVideo(const CalibrationResults& results, const std::string& inputFile,
+                                       const std::string& outputFile, VideoUndistortOptions options, VideoUndistortStats& stats) {
+    const UndistortMaps& maps = undistortMaps(results, results.imageSize);
+    options.remapKernel = remapKernel_;
+    options.pool = pool_.get();
+
+    std::cout << "Undistorting video " << inputFile << " into " << outputFile << " (" << options.ringSize
+              << " frame slots, " << remapKernelName(remapKernel_) << " remap)..." << std::endl;
+    ScopedTimer timer(options_.profiler, "undistort_video");
+    return cameracalib::undistortVideo(maps, inputFile, outputFile, options, stats);
+}
+
+CalibrationResults calibrateCamera(const std::string& imageDir, const cv::Size& checkerboardSize, const DetectionOptions& options) {
+    CalibrationEngine engine(options);
+    return engine.calibrate(imageDir, checkerboardSize);
+}
+
+} // namespace cameracalib
@@ -0,0 +1,60 @@
+#include "cameracalib/keyframes.hpp"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace cameracalib {
+
+KeyframeSelector::KeyframeSelector(const KeyframeOptions& options) : options_(options) {}
+
+bool KeyframeSelector::accept(const cv::Mat& gray) {
+    stats_.sampled++;
+
+    if (options_.minDifference > 0.0) {
+        int width = std::min(gray.cols, std::max(8, options_.thumbnailWidth));
+        int height = std::max(1, gray.rows * width / gray.cols);
+        cv::resize(gray, thumbnail_, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+
+        double limit = options_.minDifference * thumbnail_.total();
+        for (const cv::Mat& previous : thumbnails_) {
+            if (cv::norm(thumbnail_, previous, cv::NORM_L1) < limit) {
+                stats_.duplicates++;
+                return false;
+            }
+        }
+    }
+
+    if (options_.minSharpness > 0.0 && frameSharpness(gray, laplacian_) < options_.minSharpness) {
+        stats_.blurry++;
+        return false;
+    }
+
+    if (options_.minDifference > 0.0) {
+        thumbnails_.push_back(thumbnail_.clone());
+    }
+    stats_.accepted++;
+    return true;
+}
+
+double frameSharpness(const cv::Mat& gray, cv::Mat& laplacian) {
+    cv::Laplacian(gray, laplacian, CV_16S);
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(laplacian, mean, stddev);
+    return stddev[0] * stddev[0];
+}
+
+std::string keyframeName(int frameIndex) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%06d", frameIndex);
+    return name;
+}
+
+void printKeyframeStats(const KeyframeStats& stats) {
+    std::cout << "Keyframes: " << stats.accepted << " of " << stats.sampled << " sampled frame(s) accepted ("
+              << stats.duplicates << " near-duplicate(s), " << stats.blurry << " blurry), " << stats.framesRead
+              << " frame(s) read" << std::endl;
+}
+
+} // namespace cameracalib
@@ -0,0 +1,308 @@
+#include "cameracalib/detection.hpp"
+#include "cameracalib/boundedQueue.hpp"
+#include "cameracalib/cornerCache.hpp"
+#include "cameracalib/mappedFile.hpp"
+#include "cameracalib/profiler.hpp"
+#include "cameracalib/threadPool.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace cameracalib {
+
+namespace {
+
+enum { STAGE_READ, STAGE_DECODE, STAGE_GRAY, STAGE_DETECT, STAGE_REFINE, NUM_STAGES };
+
+// Configured worker count of every stage, before limiting it to the number of images
+std::vector<int> pipelineStageWorkers(const DetectionOptions& options) {
+    int numJobs = resolveNumJobs(options.numJobs);
+    int defaultWorkers[NUM_STAGES] = {1, std::max(1, numJobs / 2), 1, numJobs, 1};
+    std::vector<int> workers(NUM_STAGES);
+    for (int s = 0; s < NUM_STAGES; s++) {
+        workers[s] = std::max(1, s < static_cast<int>(options.stageWorkers.size()) ? options.stageWorkers[s] : defaultWorkers[s]);
+    }
+    return workers;
+}
+
+struct PipelineItem {
+    size_t index = 0;
+    std::vector<uchar> fileData;
+    cv::Mat frame;
+    cv::Mat gray;
+    cv::Mat search;  // downscaled copy of gray in pyramid mode, else gray itself
+    ImageDetection detection;
+    CornerCacheKey cacheKey;
+    bool haveCacheKey = false;
+};
+
+typedef std::unique_ptr<PipelineItem> PipelineItemPtr;
+
+struct PipelineStageStats {
+    std::string name;
+    int workers = 0;
+    std::atomic<size_t> items{0};
+    std::atomic<int64_t> busyNs{0};
+    std::atomic<int64_t> starvedNs{0};  // waiting for the previous stage
+    std::atomic<int64_t> blockedNs{0};  // waiting for room in the next queue
+};
+
+struct PipelineQueueStats {
+    std::atomic<size_t> samples{0};
+    std::atomic<size_t> depthSum{0};
+    std::atomic<size_t> maxDepth{0};
+
+    void record(size_t depth) {
+        samples++;
+        depthSum += depth;
+        size_t previous = maxDepth.load(std::memory_order_relaxed);
+        while (depth > previous && !maxDepth.compare_exchange_weak(previous, depth, std::memory_order_relaxed)) {
+        }
+    }
+};
+
+int64_t elapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void printPipelineStats(const std::vector<std::unique_ptr<PipelineStageStats>>& stages,
+                        const std::vector<std::unique_ptr<BoundedQueue<PipelineItemPtr>>>& queues,
+                        const std::vector<std::unique_ptr<PipelineQueueStats>>& queueStats, int64_t wallNs) {
+    std::cout << "\nPipeline statistics (wall time " << wallNs / 1e6 << " ms):" << std::endl;
+    for (const auto& stage : stages) {
+        double capacityNs = static_cast<double>(wallNs) * stage->workers;
+        std::cout << "  Stage " << stage->name << ": " << stage->workers << " worker(s), " << stage->items << " item(s), "
+                  << "busy " << 100.0 * stage->busyNs / capacityNs << "%, "
+                  << "starved " << 100.0 * stage->starvedNs / capacityNs << "%, "
+                  << "blocked " << 100.0 * stage->blockedNs / capacityNs << "%" << std::endl;
+    }
+    for (size_t q = 0; q < queues.size(); q++) {
+        const PipelineQueueStats& stats = *queueStats[q];
+        double meanDepth = stats.samples ? static_cast<double>(stats.depthSum) / stats.samples : 0.0;
+        std::cout << "  Queue " << stages[q]->name << " -> " << stages[q + 1]->name << ": capacity " << queues[q]->capacity()
+                  << ", mean depth " << meanDepth << ", max depth " << stats.maxDepth << std::endl;
+    }
+}
+
+} // namespace
+
+int pipelineThreadCount(const DetectionOptions& options) {
+    std::vector<int> workers = pipelineStageWorkers(options);
+    int total = 0;
+    for (int count : workers) {
+        total += count;
+    }
+    return total;
+}
+
+std::vector<ImageDetection> detectCheckerboardsPipelined(const std::vector<cv::String>& images, const cv::Size& checkerboardSize,
+                                                         const DetectionOptions& options, ThreadPool& stagePool, CornerCache* cache) {
+    static const char* stageNames[NUM_STAGES] = {"read", "decode", "gray", "detect", "refine"};
+
+    const size_t numImages = images.size();
+    std::vector<ImageDetection> detections(numImages);
+    if (numImages == 0) {
+        return detections;
+    }
+
+    // Every stage worker is one task on stagePool that runs until its stage has seen all
+    // images, so the tasks only make progress if all of them run at the same time
+    std::vector<int> configuredWorkers = pipelineStageWorkers(options);
+    std::vector<std::unique_ptr<PipelineStageStats>> stages;
+    std::vector<int> taskStages;
+    for (int s = 0; s < NUM_STAGES; s++) {
+        stages.emplace_back(new PipelineStageStats());
+        stages[s]->name = stageNames[s];
+        stages[s]->workers = static_cast<int>(std::min<size_t>(configuredWorkers[s], numImages));
+        taskStages.insert(taskStages.end(), stages[s]->workers, s);
+    }
+    if (taskStages.size() > static_cast<size_t>(stagePool.size())) {
+        std::cerr << "Error: The pipeline needs " << taskStages.size() << " stage threads, the pool has " << stagePool.size()
+                  << std::endl;
+        return detections;
+    }
+
+    // queues[s] connects stage s to stage s + 1
+    std::vector<std::unique_ptr<BoundedQueue<PipelineItemPtr>>> queues;
+    std::vector<std::unique_ptr<PipelineQueueStats>> queueStats;
+    for (int s = 0; s + 1 < NUM_STAGES; s++) {
+        queues.emplace_back(new BoundedQueue<PipelineItemPtr>(options.queueDepth));
+        queueStats.emplace_back(new PipelineQueueStats());
+    }
+
+    // Every image passes through every stage (failed ones just carry their status),
+    // so each stage knows it is done after handling exactly numImages items
+    std::vector<std::atomic<size_t>> claimed(NUM_STAGES);
+    for (auto& counter : claimed) {
+        counter.store(0);
+    }
+
+    std::mutex logMutex;
+    const bool reducedDecode = decodeModeScale(options.decodeMode) > 1;
+
+    auto processItem = [&](int stage, PipelineItem& item) {
+        const std::string& path = images[item.index];
+        switch (stage) {
+        case STAGE_READ:
+            {
+                std::lock_guard<std::mutex> lock(logMutex);
+                std::cout << "Processing image " << (item.index + 1) << "/" << numImages << ": \""
+                          << std::filesystem::path(path).filename().string() << "\"..." << std::endl;
+            }
+            {
+                ScopedTimer timer(options.profiler, "read");
+                readFileBytes(path, item.fileData);
+            }
+            if (cache) {
+                ScopedTimer timer(options.profiler, "cache_lookup");
+                item.haveCacheKey = CornerCache::makeKey(path, item.fileData, checkerboardSize, detectionCacheFlags(options),
+                                                         item.cacheKey);
+                if (item.haveCacheKey && cache->lookup(item.cacheKey, item.detection)) {
+                    item.detection.fromCache = true;
+                    std::vector<uchar>().swap(item.fileData);
+                }
+            }
+            break;
+        case STAGE_DECODE:
+            // Color frames are converted by the gray stage; the other modes decode to gray
+            // directly, and the reduced ones keep the file bytes for the full-resolution refine
+            if (!item.fileData.empty()) {
+                if (options.decodeMode == DecodeMode::Color) {
+                    ScopedTimer timer(options.profiler, "decode");
+                    item.frame = cv::imdecode(item.fileData, cv::IMREAD_COLOR);
+                } else {
+                    item.gray = decodeSearchImage(item.fileData, options.decodeMode, options.profiler);
+                }
+            }
+            if (!reducedDecode) {
+                std::vector<uchar>().swap(item.fileData);
+            }
+            break;
+        case STAGE_GRAY:
+            if (!item.frame.empty()) {
+                ScopedTimer timer(options.profiler, "cvt_color");
+                cv::cvtColor(item.frame, item.gray, cv::COLOR_BGR2GRAY);
+            }
+            if (!item.gray.empty()) {
+                item.detection.imageRead = true;
+                if (!reducedDecode) {
+                    item.detection.imageSize = cv::Size(item.gray.cols, item.gray.rows);
+                }
+            }
+            item.frame.release();
+            break;
+        case STAGE_DETECT:
+            if (item.detection.imageRead && !item.detection.fromCache) {
+                item.search = makeSearchImage(item.gray, decodeModeScale(options.decodeMode), checkerboardSize, options);
+                item.detection.found = searchCheckerboard(item.search, checkerboardSize, item.detection, options);
+                if (!item.detection.found) {
+                    item.detection.corners.clear();
+                    item.gray.release();
+                    item.search.release();
+                    std::vector<uchar>().swap(item.fileData);
+                }
+            }
+            break;
+        case STAGE_REFINE:
+            if (item.detection.found && !item.detection.fromCache) {
+                cv::Mat fullGray = item.gray;
+                if (reducedDecode) {
+                    ScopedTimer timer(options.profiler, "decode_full");
+                    fullGray = cv::imdecode(item.fileData, cv::IMREAD_GRAYSCALE);
+                }
+                if (fullGray.empty()) {
+                    item.detection.found = false;
+                    item.detection.corners.clear();
+                } else {
+                    item.detection.imageSize = cv::Size(fullGray.cols, fullGray.rows);
+                    refineSearchCorners(fullGray, item.search, item.detection.corners, options.profiler, options.detector);
+                }
+            }
+            item.gray.release();
+            item.search.release();
+            std::vector<uchar>().swap(item.fileData);
+            if (cache && item.haveCacheKey && !item.detection.fromCache) {
+                cache->store(item.cacheKey, item.detection);
+            }
+            break;
+        }
+    };
+
+    auto stageWorker = [&](int stage) {
+        PipelineStageStats& stats = *stages[stage];
+        for (size_t n = claimed[stage]++; n < numImages; n = claimed[stage]++) {
+            PipelineItemPtr item;
+            auto waitStart = std::chrono::steady_clock::now();
+            if (stage == STAGE_READ) {
+                item.reset(new PipelineItem());
+                item->index = n;
+            } else {
+                for (int attempt = 0; !queues[stage - 1]->tryPop(item);) {
+                    waitBackoff(attempt);
+                }
+                stats.starvedNs += elapsedNs(waitStart);
+            }
+
+            auto busyStart = std::chrono::steady_clock::now();
+            // A failed item is blanked and still passed on, since every later stage waits for
+            // exactly numImages items; letting the exception escape would stall them forever
+            const char* failure = nullptr;
+            std::string message;
+            try {
+                processItem(stage, *item);
+            } catch (const cv::Exception& e) {
+                failure = "OpenCV error";
+                message = e.what();
+            } catch (const std::exception& e) {
+                failure = "Error";
+                message = e.what();
+            } catch (...) {
+                failure = "Error";
+                message = "unknown exception";
+            }
+            if (failure) {
+                item->detection = ImageDetection();
+                std::vector<uchar>().swap(item->fileData);
+                item->frame.release();
+                item->gray.release();
+                item->search.release();
+                std::lock_guard<std::mutex> lock(logMutex);
+                std::cout << "Warning: " << failure << " while processing " << images[item->index] << ": " << message << std::endl;
+            }
+            stats.busyNs += elapsedNs(busyStart);
+            stats.items++;
+
+            if (stage == STAGE_REFINE) {
+                std::lock_guard<std::mutex> lock(logMutex);
+                logDetection(item->detection, images[item->index]);
+                detections[item->index] = std::move(item->detection);
+                continue;
+            }
+
+            auto blockStart = std::chrono::steady_clock::now();
+            for (int attempt = 0; !queues[stage]->tryPush(item);) {
+                waitBackoff(attempt);
+            }
+            stats.blockedNs += elapsedNs(blockStart);
+            queueStats[stage]->record(queues[stage]->size());
+        }
+    };
+
+    auto pipelineStart = std::chrono::steady_clock::now();
+    stagePool.parallelFor(taskStages.size(), [&](size_t task, int) { stageWorker(taskStages[task]); });
+
+    if (options.pipelineStats) {
+        printPipelineStats(stages, queues, queueStats, elapsedNs(pipelineStart));
+    }
+
+    return detections;
+}
+
+} // namespace cameracalib
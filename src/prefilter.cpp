@@ -0,0 +1,125 @@
+#include "cameracalib/prefilter.hpp"
+#include "cameracalib/cornerCache.hpp"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <iostream>
+
+namespace cameracalib {
+
+namespace {
+
+// Saddle responses below this fraction of the strongest one are not counted
+const double kRelativeSaddleResponse = 0.1;
+
+} // namespace
+
+void PrefilterStats::add(const PrefilterOutcome& outcome) {
+    checked++;
+    filterMs += outcome.filterMs;
+    if (outcome.rejected) {
+        rejected++;
+    }
+    if (outcome.audited) {
+        audited++;
+        auditMs += outcome.auditMs;
+        if (outcome.auditFound) {
+            falseRejects++;
+        }
+    }
+}
+
+PrefilterScores computePrefilterScores(const cv::Mat& gray, const PrefilterOptions& options) {
+    PrefilterScores scores;
+    if (gray.empty()) {
+        return scores;
+    }
+
+    cv::Mat thumbnail = gray;
+    int width = std::max(16, options.thumbnailWidth);
+    if (gray.cols > width) {
+        cv::Size size(width, std::max(1, gray.rows * width / gray.cols));
+        cv::resize(gray, thumbnail, size, 0, 0, cv::INTER_AREA);
+    }
+
+    // The whole thumbnail is hashed; images can share many rows, e.g. black borders or sky
+    cv::Mat continuous = thumbnail.isContinuous() ? thumbnail : thumbnail.clone();
+    scores.thumbnailHash = hashBytes(continuous.ptr<uchar>(0), continuous.total() * continuous.elemSize());
+
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(thumbnail, mean, stddev);
+    scores.contrast = stddev[0];
+
+    cv::Mat laplacian;
+    cv::Laplacian(thumbnail, laplacian, CV_16S);
+    cv::meanStdDev(laplacian, mean, stddev);
+    scores.sharpness = stddev[0] * stddev[0];
+
+    // Second derivatives of the smoothed thumbnail; at a saddle the curvatures along the two
+    // axes of the corner have opposite signs, so the Hessian determinant is strongly negative
+    cv::Mat smooth, dxx, dyy, dxy;
+    cv::GaussianBlur(thumbnail, smooth, cv::Size(5, 5), 1.0);
+    cv::Sobel(smooth, dxx, CV_32F, 2, 0, 3);
+    cv::Sobel(smooth, dyy, CV_32F, 0, 2, 3);
+    cv::Sobel(smooth, dxy, CV_32F, 1, 1, 3);
+    cv::Mat response = dxy.mul(dxy) - dxx.mul(dyy);
+
+    double maxResponse = 0.0;
+    cv::minMaxLoc(response, nullptr, &maxResponse);
+    if (maxResponse <= 0.0) {
+        return scores;
+    }
+
+    cv::Mat localMax;
+    cv::dilate(response, localMax, cv::Mat(), cv::Point(-1, -1), 2);
+    float threshold = static_cast<float>(kRelativeSaddleResponse * maxResponse);
+    for (int y = 0; y < response.rows; y++) {
+        const float* r = response.ptr<float>(y);
+        const float* m = localMax.ptr<float>(y);
+        for (int x = 0; x < response.cols; x++) {
+            if (r[x] > threshold && r[x] >= m[x]) {
+                scores.saddlePoints++;
+            }
+        }
+    }
+    return scores;
+}
+
+bool prefilterAccepts(const PrefilterScores& scores, const cv::Size& checkerboardSize, const PrefilterOptions& options) {
+    if (scores.contrast < options.minContrast || scores.sharpness < options.minSharpness) {
+        return false;
+    }
+    return scores.saddlePoints >= options.minSaddleFraction * checkerboardSize.area();
+}
+
+bool prefilterAuditSelects(const PrefilterScores& scores, double auditFraction) {
+    if (auditFraction <= 0.0) {
+        return false;
+    }
+    if (auditFraction >= 1.0) {
+        return true;
+    }
+    return static_cast<double>(scores.thumbnailHash % 1000000) < auditFraction * 1000000.0;
+}
+
+void printPrefilterStats(const PrefilterStats& stats) {
+    std::cout << "Prefilter: rejected " << stats.rejected << " of " << stats.checked << " image(s) in " << stats.filterMs
+              << " ms" << std::endl;
+    if (stats.audited == 0) {
+        if (stats.rejected > 0) {
+            std::cout << "  No rejected image was audited; use --prefilter-audit to measure false rejects and time saved" << std::endl;
+        }
+        return;
+    }
+
+    // Audited images are a sample of the rejected ones, so their full search time is what
+    // every rejection saves on average
+    double meanSearchMs = stats.auditMs / stats.audited;
+    size_t skipped = stats.rejected - stats.audited;
+    std::cout << "  Audit: " << stats.falseRejects << " of " << stats.audited << " rejected image(s) contained the board ("
+              << 100.0 * stats.falseRejects / stats.audited << "% false rejects)" << std::endl;
+    std::cout << "  Estimated time saved: " << skipped * meanSearchMs - stats.filterMs << " ms (" << skipped
+              << " skipped search(es) of " << meanSearchMs << " ms each, minus filtering)" << std::endl;
+}
+
+} // namespace cameracalib
@@ -0,0 +1,104 @@
+#include "cameracalib/profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+namespace cameracalib {
+
+TimingStats computeTimingStats(std::vector<double> samplesMs) {
+    TimingStats stats;
+    if (samplesMs.empty()) {
+        return stats;
+    }
+
+    std::sort(samplesMs.begin(), samplesMs.end());
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * samplesMs.size()));
+        return samplesMs[std::min(samplesMs.size(), std::max<size_t>(rank, 1)) - 1];
+    };
+
+    stats.count = samplesMs.size();
+    stats.totalMs = std::accumulate(samplesMs.begin(), samplesMs.end(), 0.0);
+    stats.minMs = samplesMs.front();
+    stats.meanMs = stats.totalMs / stats.count;
+    stats.p50Ms = percentile(0.50);
+    stats.p95Ms = percentile(0.95);
+    stats.maxMs = samplesMs.back();
+    return stats;
+}
+
+Profiler::Profiler() : start_(std::chrono::steady_clock::now()) {}
+
+void Profiler::record(const std::string& stage, double milliseconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = samples_.find(stage);
+    if (it == samples_.end()) {
+        stageOrder_.push_back(stage);
+        it = samples_.emplace(stage, std::vector<double>()).first;
+    }
+    it->second.push_back(milliseconds);
+}
+
+std::vector<std::pair<std::string, TimingStats>> Profiler::summary() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::pair<std::string, TimingStats>> result;
+    for (const std::string& stage : stageOrder_) {
+        result.emplace_back(stage, computeTimingStats(samples_.at(stage)));
+    }
+    return result;
+}
+
+double Profiler::wallTimeMs() const {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_;
+    return elapsed.count();
+}
+
+void Profiler::print(std::ostream& out) const {
+    out << "\nTimings (ms):" << std::endl;
+    out << "  " << std::left << std::setw(24) << "stage" << std::right << std::setw(8) << "count" << std::setw(12) << "total"
+        << std::setw(10) << "min" << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p95"
+        << std::setw(10) << "max" << std::endl;
+    out << std::fixed << std::setprecision(3);
+    for (const auto& entry : summary()) {
+        const TimingStats& stats = entry.second;
+        out << "  " << std::left << std::setw(24) << entry.first << std::right << std::setw(8) << stats.count
+            << std::setw(12) << stats.totalMs << std::setw(10) << stats.minMs << std::setw(10) << stats.meanMs
+            << std::setw(10) << stats.p50Ms << std::setw(10) << stats.p95Ms << std::setw(10) << stats.maxMs << std::endl;
+    }
+    out << std::defaultfloat << std::setprecision(6);
+}
+
+bool Profiler::saveJSON(const std::string& outputFile) const {
+    std::ofstream file(outputFile);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write to profile file " << outputFile << std::endl;
+        return false;
+    }
+
+    std::vector<std::pair<std::string, TimingStats>> stages = summary();
+
+    file << std::setprecision(9);
+    file << "{\n";
+    file << "  \"wall_time_ms\": " << wallTimeMs() << ",\n";
+    file << "  \"timings\": [\n";
+    for (size_t i = 0; i < stages.size(); i++) {
+        const TimingStats& stats = stages[i].second;
+        file << "    {\"stage\": \"" << stages[i].first << "\", \"count\": " << stats.count
+             << ", \"total_ms\": " << stats.totalMs << ", \"min_ms\": " << stats.minMs << ", \"mean_ms\": " << stats.meanMs
+             << ", \"p50_ms\": " << stats.p50Ms << ", \"p95_ms\": " << stats.p95Ms << ", \"max_ms\": " << stats.maxMs << "}";
+        if (i < stages.size() - 1) file << ",";
+        file << "\n";
+    }
+    file << "  ]\n";
+    file << "}\n";
+
+    file.close();
+    std::cout << "Timing profile saved to: " << outputFile << std::endl;
+    return true;
+}
+
+} // namespace cameracalib
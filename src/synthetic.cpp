@@ -0,0 +1,264 @@
+#include "cameracalib/synthetic.hpp"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace cameracalib {
+
+namespace {
+
+const uchar kBlackLevel = 40;
+const uchar kWhiteLevel = 215;
+const uchar kBackgroundLevel = 120;
+
+const int kMaxPoseAttempts = 1000;
+
+// Gray level of the board plane at (x, y), in the square units of checkerboardObjectPoints.
+// Inner corner (0, 0) is where the first four squares meet; the board is surrounded by one
+// square of white border.
+uchar boardLevel(double x, double y, const cv::Size& checkerboardSize) {
+    if (x < -2.0 || y < -2.0 || x >= checkerboardSize.width + 1.0 || y >= checkerboardSize.height + 1.0) {
+        return kBackgroundLevel;
+    }
+    if (x < -1.0 || y < -1.0 || x >= checkerboardSize.width || y >= checkerboardSize.height) {
+        return kWhiteLevel;
+    }
+    int column = static_cast<int>(std::floor(x)) + 1;
+    int row = static_cast<int>(std::floor(y)) + 1;
+    return (column + row) % 2 == 0 ? kBlackLevel : kWhiteLevel;
+}
+
+// Outline of the white border, sampled densely enough to follow strong distortion
+std::vector<cv::Point3f> boardOutline(const cv::Size& checkerboardSize) {
+    const int samplesPerSide = 16;
+    float left = -2.0f, top = -2.0f;
+    float right = checkerboardSize.width + 1.0f, bottom = checkerboardSize.height + 1.0f;
+
+    std::vector<cv::Point3f> outline;
+    for (int i = 0; i < samplesPerSide; i++) {
+        float t = static_cast<float>(i) / samplesPerSide;
+        outline.push_back(cv::Point3f(left + t * (right - left), top, 0));
+        outline.push_back(cv::Point3f(right, top + t * (bottom - top), 0));
+        outline.push_back(cv::Point3f(right - t * (right - left), bottom, 0));
+        outline.push_back(cv::Point3f(left, bottom - t * (bottom - top), 0));
+    }
+    return outline;
+}
+
+// Rotation about x, then y, then z, as a row-major 3x3 matrix
+void eulerRotation(double rx, double ry, double rz, double R[9]) {
+    double cx = std::cos(rx), sx = std::sin(rx);
+    double cy = std::cos(ry), sy = std::sin(ry);
+    double cz = std::cos(rz), sz = std::sin(rz);
+    R[0] = cz * cy; R[1] = cz * sy * sx - sz * cx; R[2] = cz * sy * cx + sz * sx;
+    R[3] = sz * cy; R[4] = sz * sy * sx + cz * cx; R[5] = sz * sy * cx - cz * sx;
+    R[6] = -sy;     R[7] = cy * sx;                R[8] = cy * cx;
+}
+
+// Largest normalized radius inside the image; points beyond it would fold back into the
+// image under a strongly distorting lens model
+double maxNormalizedRadius(const cv::Mat& cameraMatrix, const cv::Mat& distCoeffs, const cv::Size& imageSize) {
+    std::vector<cv::Point2f> imageCorners = {
+        cv::Point2f(0, 0), cv::Point2f(imageSize.width - 1.0f, 0),
+        cv::Point2f(0, imageSize.height - 1.0f), cv::Point2f(imageSize.width - 1.0f, imageSize.height - 1.0f)};
+    std::vector<cv::Point2f> normalized;
+    cv::undistortPoints(imageCorners, normalized, cameraMatrix, distCoeffs);
+
+    double maxRadius = 0.0;
+    for (const cv::Point2f& p : normalized) {
+        maxRadius = std::max(maxRadius, std::sqrt(static_cast<double>(p.x) * p.x + static_cast<double>(p.y) * p.y));
+    }
+    return maxRadius;
+}
+
+} // namespace
+
+cv::Mat syntheticCameraMatrix(const SyntheticOptions& options) {
+    double f = options.focalLength > 0.0 ? options.focalLength : 0.9 * options.imageSize.width;
+    double cx = options.principalPoint.x >= 0.0 ? options.principalPoint.x : (options.imageSize.width - 1) / 2.0;
+    double cy = options.principalPoint.y >= 0.0 ? options.principalPoint.y : (options.imageSize.height - 1) / 2.0;
+
+    cv::Mat cameraMatrix = cv::Mat::eye(3, 3, CV_64F);
+    cameraMatrix.at<double>(0, 0) = f;
+    cameraMatrix.at<double>(1, 1) = f;
+    cameraMatrix.at<double>(0, 2) = cx;
+    cameraMatrix.at<double>(1, 2) = cy;
+    return cameraMatrix;
+}
+
+cv::Mat syntheticDistCoeffs(const SyntheticOptions& options) {
+    // Same 5x1 layout as the coefficients cv::calibrateCamera returns
+    cv::Mat distCoeffs = cv::Mat::zeros(5, 1, CV_64F);
+    for (size_t i = 0; i < options.distortion.size() && i < 5; i++) {
+        distCoeffs.at<double>(static_cast<int>(i), 0) = options.distortion[i];
+    }
+    return distCoeffs;
+}
+
+bool generateSyntheticPoses(const SyntheticOptions& options, std::vector<SyntheticView>& views) {
+    cv::Mat cameraMatrix = syntheticCameraMatrix(options);
+    cv::Mat distCoeffs = syntheticDistCoeffs(options);
+    const cv::Size& board = options.checkerboardSize;
+    const cv::Size& imageSize = options.imageSize;
+    double f = cameraMatrix.at<double>(0, 0);
+    double cx = cameraMatrix.at<double>(0, 2);
+    double cy = cameraMatrix.at<double>(1, 2);
+
+    std::vector<cv::Point3f> objp = checkerboardObjectPoints(board);
+    std::vector<cv::Point3f> outline = boardOutline(board);
+    double maxRadius = maxNormalizedRadius(cameraMatrix, distCoeffs, imageSize);
+    double centerX = (board.width - 1) / 2.0;
+    double centerY = (board.height - 1) / 2.0;
+    const double toRadians = CV_PI / 180.0;
+
+    cv::RNG rng(options.seed);
+    views.clear();
+    views.reserve(options.numViews);
+
+    for (int v = 0; v < options.numViews; v++) {
+        bool placed = false;
+        for (int attempt = 0; attempt < kMaxPoseAttempts && !placed; attempt++) {
+            // Distance that makes the board (with its border) span the requested part of the width
+            double coverage = rng.uniform(options.minCoverage, options.maxCoverage);
+            double distance = f * (board.width + 3) / (coverage * imageSize.width);
+
+            double R[9];
+            eulerRotation(rng.uniform(-options.maxTiltDegrees, options.maxTiltDegrees) * toRadians,
+                          rng.uniform(-options.maxTiltDegrees, options.maxTiltDegrees) * toRadians,
+                          rng.uniform(-options.maxRollDegrees, options.maxRollDegrees) * toRadians, R);
+
+            // Board center on the viewing ray of a random pixel
+            double u = rng.uniform(0.0, static_cast<double>(imageSize.width));
+            double w = rng.uniform(0.0, static_cast<double>(imageSize.height));
+            double t[3] = {(u - cx) / f * distance, (w - cy) / f * distance, distance};
+            for (int r = 0; r < 3; r++) {
+                t[r] -= R[r * 3] * centerX + R[r * 3 + 1] * centerY;
+            }
+
+            // Every outline point must lie in front of the camera and within the image's field of view
+            bool inView = true;
+            for (const cv::Point3f& p : outline) {
+                double x = R[0] * p.x + R[1] * p.y + t[0];
+                double y = R[3] * p.x + R[4] * p.y + t[1];
+                double z = R[6] * p.x + R[7] * p.y + t[2];
+                if (z <= 0.0 || std::sqrt(x * x + y * y) / z > maxRadius) {
+                    inView = false;
+                    break;
+                }
+            }
+            if (!inView) {
+                continue;
+            }
+
+            SyntheticView view;
+            cv::Rodrigues(cv::Mat(3, 3, CV_64F, R), view.rvec);
+            view.tvec = cv::Mat(3, 1, CV_64F, t).clone();
+
+            std::vector<cv::Point2f> projectedOutline;
+            cv::projectPoints(outline, view.rvec, view.tvec, cameraMatrix, distCoeffs, projectedOutline);
+            const float margin = 2.0f;
+            for (const cv::Point2f& p : projectedOutline) {
+                if (p.x < margin || p.y < margin || p.x > imageSize.width - 1 - margin || p.y > imageSize.height - 1 - margin) {
+                    inView = false;
+                    break;
+                }
+            }
+            if (!inView) {
+                continue;
+            }
+
+            cv::projectPoints(objp, view.rvec, view.tvec, cameraMatrix, distCoeffs, view.corners);
+            views.push_back(view);
+            placed = true;
+        }
+
+        if (!placed) {
+            std::cerr << "Error: Could not place the board in view " << v << "; reduce the coverage or tilt range." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void renderSyntheticView(const SyntheticOptions& options, size_t viewIndex, SyntheticView& view) {
+    cv::Mat cameraMatrix = syntheticCameraMatrix(options);
+    cv::Mat distCoeffs = syntheticDistCoeffs(options);
+    int supersample = std::max(1, options.supersample);
+    cv::Size renderSize(options.imageSize.width * supersample, options.imageSize.height * supersample);
+
+    // Homography from the board plane to undistorted pixels, inverted to trace pixels back onto the board
+    cv::Mat R;
+    cv::Rodrigues(view.rvec, R);
+    cv::Mat Rt;
+    cv::hconcat(R.colRange(0, 2), view.tvec, Rt);
+    cv::Mat H = cameraMatrix * Rt;
+    cv::Mat Hinv = H.inv();
+    const double* h = Hinv.ptr<double>(0);
+
+    cv::Mat rendered(renderSize, CV_8UC1);
+    std::vector<cv::Point2f> samples(renderSize.width);
+    std::vector<cv::Point2f> ideal;
+    cv::TermCriteria undistortCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 20, 1e-6);
+
+    for (int y = 0; y < renderSize.height; y++) {
+        float sampleY = (y + 0.5f) / supersample - 0.5f;
+        for (int x = 0; x < renderSize.width; x++) {
+            samples[x] = cv::Point2f((x + 0.5f) / supersample - 0.5f, sampleY);
+        }
+        // Distorted pixel positions -> ideal pinhole pixel positions
+        cv::undistortPoints(samples, ideal, cameraMatrix, distCoeffs, cv::noArray(), cameraMatrix, undistortCriteria);
+
+        uchar* row = rendered.ptr<uchar>(y);
+        for (int x = 0; x < renderSize.width; x++) {
+            double u = ideal[x].x, v = ideal[x].y;
+            double bw = h[6] * u + h[7] * v + h[8];
+            if (bw <= 0.0) {
+                row[x] = kBackgroundLevel;  // ray points away from the board plane
+                continue;
+            }
+            double bx = (h[0] * u + h[1] * v + h[2]) / bw;
+            double by = (h[3] * u + h[4] * v + h[5]) / bw;
+            row[x] = boardLevel(bx, by, options.checkerboardSize);
+        }
+    }
+
+    if (supersample > 1) {
+        cv::resize(rendered, view.image, options.imageSize, 0, 0, cv::INTER_AREA);
+    } else {
+        view.image = rendered;
+    }
+
+    if (options.blurSigma > 0.0) {
+        cv::GaussianBlur(view.image, view.image, cv::Size(0, 0), options.blurSigma);
+    }
+
+    if (options.noiseSigma > 0.0) {
+        cv::RNG rng(options.seed ^ ((viewIndex + 1) * 0x9E3779B97F4A7C15ULL));
+        cv::Mat noisy, noise(view.image.size(), CV_32F);
+        rng.fill(noise, cv::RNG::NORMAL, 0.0, options.noiseSigma);
+        view.image.convertTo(noisy, CV_32F);
+        cv::add(noisy, noise, noisy);
+        noisy.convertTo(view.image, CV_8U);
+    }
+}
+
+CalibrationResults syntheticGroundTruth(const SyntheticOptions& options, const std::vector<SyntheticView>& views) {
+    CalibrationResults results;
+    results.cameraMatrix = syntheticCameraMatrix(options);
+    results.distCoeffs = syntheticDistCoeffs(options);
+    for (const SyntheticView& view : views) {
+        results.rvecs.push_back(view.rvec);
+        results.tvecs.push_back(view.tvec);
+    }
+    results.success = true;
+    results.imageSize = options.imageSize;
+    results.checkerboardSize = options.checkerboardSize;
+    results.numImagesUsed = static_cast<int>(views.size());
+    results.meanReprojectionError = 0.0;
+    return results;
+}
+
+} // namespace cameracalib
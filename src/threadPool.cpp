@@ -0,0 +1,98 @@
+#include "cameracalib/threadPool.hpp"
+
+#include <algorithm>
+
+namespace cameracalib {
+
+ThreadPool::ThreadPool(int numThreads) {
+    for (int worker = 1; worker < std::max(1, numThreads); worker++) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    jobReady_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t index, int worker)>& task) {
+    if (count == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> jobLock(jobMutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        count_ = count;
+        nextIndex_ = 0;
+        error_ = nullptr;
+        activeWorkers_ = static_cast<int>(workers_.size());
+        generation_++;
+    }
+    jobReady_.notify_all();
+
+    runTasks(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    jobDone_.wait(lock, [this]() { return activeWorkers_ == 0; });
+    task_ = nullptr;
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::workerLoop(int worker) {
+    size_t seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            jobReady_.wait(lock, [&]() { return stopping_ || generation_ != seenGeneration; });
+            if (stopping_) {
+                return;
+            }
+            seenGeneration = generation_;
+        }
+
+        runTasks(worker);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--activeWorkers_ == 0) {
+            jobDone_.notify_all();
+        }
+    }
+}
+
+void ThreadPool::runTasks(int worker) {
+    for (;;) {
+        size_t index;
+        const std::function<void(size_t, int)>* task;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (nextIndex_ >= count_ || error_) {
+                return;
+            }
+            index = nextIndex_++;
+            task = task_;
+        }
+
+        try {
+            (*task)(index, worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+    }
+}
+
+} // namespace cameracalib
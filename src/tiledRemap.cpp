@@ -0,0 +1,324 @@
+#include "cameracalib/tiledRemap.hpp"
+#include "cameracalib/threadPool.hpp"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// SSE2 is part of every x86-64 target; other targets use the scalar interior kernel
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CAMERACALIB_REMAP_SSE2
+#endif
+
+namespace cameracalib {
+
+namespace {
+
+// 256 x 64 destination pixels: with up to 8 bytes of map and 6 bytes of destination and
+// source footprint per pixel, one tile touches well under 256 KB
+const int kTileWidth = 256;
+const int kTileHeight = 64;
+
+const int kFractionBits = cv::INTER_BITS;
+const int kFractionMask = (1 << kFractionBits) - 1;
+const int kOne = 1 << kFractionBits;
+const int kWeightShift = 2 * kFractionBits;
+const int kWeightRound = 1 << (kWeightShift - 1);
+
+// Integer source positions and 1/32 pixel fractions of count destination pixels of one row
+void fetchPositions(const UndistortMaps& maps, int y, int x0, int count, int* sx, int* sy, int* fx, int* fy) {
+    if (maps.format() == UndistortMapFormat::Fixed) {
+        const short* positions = maps.map1.ptr<short>(y) + 2 * x0;
+        const ushort* fractions = maps.map2.ptr<ushort>(y) + x0;
+        for (int i = 0; i < count; i++) {
+            sx[i] = positions[2 * i];
+            sy[i] = positions[2 * i + 1];
+            fx[i] = fractions[i] & kFractionMask;
+            fy[i] = fractions[i] >> kFractionBits;
+        }
+    } else {
+        // Float maps are read directly, grid maps are interpolated between their mesh nodes here
+        float mapX[kTileWidth], mapY[kTileWidth];
+        mapRowPositions(maps, y, x0, count, mapX, mapY);
+        for (int i = 0; i < count; i++) {
+            // Arithmetic shifts floor negative positions, like convertMaps
+            int ix = cvRound(mapX[i] * kOne);
+            int iy = cvRound(mapY[i] * kOne);
+            sx[i] = ix >> kFractionBits;
+            sy[i] = iy >> kFractionBits;
+            fx[i] = ix & kFractionMask;
+            fy[i] = iy & kFractionMask;
+        }
+    }
+}
+
+// Source sample for the border path; pixels outside the image are black
+template <int CN>
+inline int sampleOrZero(const cv::Mat& src, int x, int y, int c) {
+    if (x < 0 || y < 0 || x >= src.cols || y >= src.rows) {
+        return 0;
+    }
+    return src.ptr<uchar>(y)[x * CN + c];
+}
+
+// Destination pixel whose 2x2 source neighborhood is at least partly outside the image
+template <int CN>
+void interpolateBorderPixel(const cv::Mat& src, int sx, int sy, int fx, int fy, uchar* dst) {
+    int w00 = (kOne - fx) * (kOne - fy);
+    int w01 = fx * (kOne - fy);
+    int w10 = (kOne - fx) * fy;
+    int w11 = fx * fy;
+    for (int c = 0; c < CN; c++) {
+        int sum = sampleOrZero<CN>(src, sx, sy, c) * w00 + sampleOrZero<CN>(src, sx + 1, sy, c) * w01 +
+                  sampleOrZero<CN>(src, sx, sy + 1, c) * w10 + sampleOrZero<CN>(src, sx + 1, sy + 1, c) * w11;
+        dst[c] = static_cast<uchar>((sum + kWeightRound) >> kWeightShift);
+    }
+}
+
+// Interior pixels [begin, count): the whole 2x2 neighborhood is inside the image, so there
+// are no bounds checks, and the channel loop has a fixed trip count
+template <int CN>
+void interpolateInteriorScalar(const uchar* base, size_t step, const int* sx, const int* sy, const int* fx, const int* fy,
+                               int begin, int count, uchar* dst) {
+    for (int i = begin; i < count; i++) {
+        int w00 = (kOne - fx[i]) * (kOne - fy[i]);
+        int w01 = fx[i] * (kOne - fy[i]);
+        int w10 = (kOne - fx[i]) * fy[i];
+        int w11 = fx[i] * fy[i];
+        const uchar* top = base + sy[i] * step + sx[i] * CN;
+        const uchar* bottom = top + step;
+        for (int c = 0; c < CN; c++) {
+            dst[i * CN + c] = static_cast<uchar>(
+                (top[c] * w00 + top[c + CN] * w01 + bottom[c] * w10 + bottom[c + CN] * w11 + kWeightRound) >> kWeightShift);
+        }
+    }
+}
+
+#ifdef CAMERACALIB_REMAP_SSE2
+
+// Adds adjacent 32-bit lanes: [a0 + a1, a2 + a3, b0 + b1, b2 + b3]
+inline __m128i sumLanePairs(__m128i a, __m128i b) {
+    __m128i sumA = _mm_add_epi32(a, _mm_srli_epi64(a, 32));
+    __m128i sumB = _mm_add_epi32(b, _mm_srli_epi64(b, 32));
+    return _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(sumA), _mm_castsi128_ps(sumB), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+inline __m128i roundWeightedSums(__m128i sums) {
+    return _mm_srai_epi32(_mm_add_epi32(sums, _mm_set1_epi32(kWeightRound)), kWeightShift);
+}
+
+inline __m128i loadBytes4(const uchar* p) {
+    int value;
+    std::memcpy(&value, p, sizeof(value));
+    return _mm_cvtsi32_si128(value);
+}
+
+// Puts the gray pixel pairs at top and top + step into 16-bit lanes Lane and Lane + 1
+template <int Lane>
+inline __m128i insertPixelPairs(__m128i v, const uchar* top, size_t step) {
+    uint16_t pair;
+    std::memcpy(&pair, top, sizeof(pair));
+    v = _mm_insert_epi16(v, pair, Lane);
+    std::memcpy(&pair, top + step, sizeof(pair));
+    return _mm_insert_epi16(v, pair, Lane + 1);
+}
+
+// Gray: eight pixels per step. The horizontal neighbors of a pixel are adjacent bytes, so
+// each row of the neighborhood is one 16-bit load; the four weights of every pixel are
+// computed in 16-bit lanes and applied with one multiply-add per two pixels.
+void interpolateInterior1(const uchar* base, size_t step, const int* sx, const int* sy, const int* fx, const int* fy,
+                          int count, uchar* dst) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(kOne);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // Pixel j contributes its top pair, then its bottom pair
+        auto topLeft = [&](int j) { return base + sy[i + j] * step + sx[i + j]; };
+        __m128i pixels0to3 = insertPixelPairs<0>(zero, topLeft(0), step);
+        pixels0to3 = insertPixelPairs<2>(pixels0to3, topLeft(1), step);
+        pixels0to3 = insertPixelPairs<4>(pixels0to3, topLeft(2), step);
+        pixels0to3 = insertPixelPairs<6>(pixels0to3, topLeft(3), step);
+        __m128i pixels4to7 = insertPixelPairs<0>(zero, topLeft(4), step);
+        pixels4to7 = insertPixelPairs<2>(pixels4to7, topLeft(5), step);
+        pixels4to7 = insertPixelPairs<4>(pixels4to7, topLeft(6), step);
+        pixels4to7 = insertPixelPairs<6>(pixels4to7, topLeft(7), step);
+
+        __m128i x = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(fx + i)),
+                                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(fx + i + 4)));
+        __m128i y = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(fy + i)),
+                                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(fy + i + 4)));
+        __m128i inverseX = _mm_sub_epi16(one, x);
+        __m128i inverseY = _mm_sub_epi16(one, y);
+        __m128i w00 = _mm_mullo_epi16(inverseX, inverseY);
+        __m128i w01 = _mm_mullo_epi16(x, inverseY);
+        __m128i w10 = _mm_mullo_epi16(inverseX, y);
+        __m128i w11 = _mm_mullo_epi16(x, y);
+        // Per pixel w00, w01, w10, w11, in the lane order of the pixel vectors
+        __m128i topLow = _mm_unpacklo_epi16(w00, w01), bottomLow = _mm_unpacklo_epi16(w10, w11);
+        __m128i topHigh = _mm_unpackhi_epi16(w00, w01), bottomHigh = _mm_unpackhi_epi16(w10, w11);
+
+        __m128i sums0 = sumLanePairs(_mm_madd_epi16(_mm_unpacklo_epi8(pixels0to3, zero), _mm_unpacklo_epi32(topLow, bottomLow)),
+                                     _mm_madd_epi16(_mm_unpackhi_epi8(pixels0to3, zero), _mm_unpackhi_epi32(topLow, bottomLow)));
+        __m128i sums1 = sumLanePairs(_mm_madd_epi16(_mm_unpacklo_epi8(pixels4to7, zero), _mm_unpacklo_epi32(topHigh, bottomHigh)),
+                                     _mm_madd_epi16(_mm_unpackhi_epi8(pixels4to7, zero), _mm_unpackhi_epi32(topHigh, bottomHigh)));
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(roundWeightedSums(sums0), roundWeightedSums(sums1)), zero);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), packed);
+    }
+    interpolateInteriorScalar<1>(base, step, sx, sy, fx, fy, i, count, dst);
+}
+
+// BGR: four pixels per step, one vector per pixel. Interleaving the bytes at top and top + 3
+// pairs every channel with its right neighbor, so one multiply-add per row of the
+// neighborhood weights all three channels.
+void interpolateInterior3(const uchar* base, size_t step, const int* sx, const int* sy, const int* fx, const int* fy,
+                          int count, uchar* dst) {
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i sums[4];
+        for (int j = 0; j < 4; j++) {
+            int x = fx[i + j], y = fy[i + j];
+            __m128i topWeights = _mm_set1_epi32(((x * (kOne - y)) << 16) | ((kOne - x) * (kOne - y)));
+            __m128i bottomWeights = _mm_set1_epi32(((x * y) << 16) | ((kOne - x) * y));
+            const uchar* top = base + sy[i + j] * step + sx[i + j] * 3;
+            const uchar* bottom = top + step;
+            // Bytes 2..5 shifted down by one, so nothing past the right neighbor is read
+            __m128i topRight = _mm_srli_epi32(loadBytes4(top + 2), 8);
+            __m128i bottomRight = _mm_srli_epi32(loadBytes4(bottom + 2), 8);
+            __m128i topPairs = _mm_unpacklo_epi8(_mm_unpacklo_epi8(loadBytes4(top), topRight), zero);
+            __m128i bottomPairs = _mm_unpacklo_epi8(_mm_unpacklo_epi8(loadBytes4(bottom), bottomRight), zero);
+            sums[j] = roundWeightedSums(
+                _mm_add_epi32(_mm_madd_epi16(topPairs, topWeights), _mm_madd_epi16(bottomPairs, bottomWeights)));
+        }
+        // Lane 3 of every pixel is padding
+        alignas(16) uchar packed[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(packed),
+                        _mm_packus_epi16(_mm_packs_epi32(sums[0], sums[1]), _mm_packs_epi32(sums[2], sums[3])));
+        uchar* out = dst + i * 3;
+        for (int j = 0; j < 4; j++) {
+            out[3 * j] = packed[4 * j];
+            out[3 * j + 1] = packed[4 * j + 1];
+            out[3 * j + 2] = packed[4 * j + 2];
+        }
+    }
+    interpolateInteriorScalar<3>(base, step, sx, sy, fx, fy, i, count, dst);
+}
+
+#endif
+
+template <int CN>
+void interpolateInterior(const uchar* base, size_t step, const int* sx, const int* sy, const int* fx, const int* fy,
+                         int count, uchar* dst) {
+#ifdef CAMERACALIB_REMAP_SSE2
+    if (CN == 1) {
+        interpolateInterior1(base, step, sx, sy, fx, fy, count, dst);
+        return;
+    }
+    if (CN == 3) {
+        interpolateInterior3(base, step, sx, sy, fx, fy, count, dst);
+        return;
+    }
+#endif
+    interpolateInteriorScalar<CN>(base, step, sx, sy, fx, fy, 0, count, dst);
+}
+
+// Splits a row into runs of interior pixels, which go through the branch-free (and, where
+// available, SSE2) kernel, and the border pixels between them
+template <int CN>
+void interpolateRow(const cv::Mat& src, const int* sx, const int* sy, const int* fx, const int* fy, int count, uchar* dst) {
+    const unsigned lastX = static_cast<unsigned>(src.cols - 1);
+    const unsigned lastY = static_cast<unsigned>(src.rows - 1);
+
+    int i = 0;
+    while (i < count) {
+        int begin = i;
+        while (i < count && static_cast<unsigned>(sx[i]) < lastX && static_cast<unsigned>(sy[i]) < lastY) {
+            i++;
+        }
+        if (i > begin) {
+            interpolateInterior<CN>(src.data, src.step, sx + begin, sy + begin, fx + begin, fy + begin, i - begin,
+                                    dst + begin * CN);
+        }
+        for (; i < count && !(static_cast<unsigned>(sx[i]) < lastX && static_cast<unsigned>(sy[i]) < lastY); i++) {
+            interpolateBorderPixel<CN>(src, sx[i], sy[i], fx[i], fy[i], dst + i * CN);
+        }
+    }
+}
+
+template <int CN>
+void remapTile(const UndistortMaps& maps, const cv::Mat& src, cv::Mat& dst, const cv::Rect& tile) {
+    int sx[kTileWidth], sy[kTileWidth], fx[kTileWidth], fy[kTileWidth];
+    for (int y = tile.y; y < tile.y + tile.height; y++) {
+        fetchPositions(maps, y, tile.x, tile.width, sx, sy, fx, fy);
+        interpolateRow<CN>(src, sx, sy, fx, fy, tile.width, dst.ptr<uchar>(y) + tile.x * CN);
+    }
+}
+
+} // namespace
+
+bool parseRemapKernel(const std::string& name, RemapKernel& kernel) {
+    if (name == "opencv") {
+        kernel = RemapKernel::OpenCV;
+    } else if (name == "tiled") {
+        kernel = RemapKernel::Tiled;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* remapKernelName(RemapKernel kernel) {
+    return kernel == RemapKernel::Tiled ? "tiled" : "opencv";
+}
+
+bool tiledRemapSupports(const cv::Mat& src) {
+    return src.depth() == CV_8U && (src.channels() == 1 || src.channels() == 3);
+}
+
+void remapTiled(const UndistortMaps& maps, const cv::Mat& src, cv::Mat& dst, ThreadPool* pool) {
+    if (!tiledRemapSupports(src)) {
+        remapImage(maps, src, dst);
+        return;
+    }
+
+    // Writing into src in place would corrupt later tiles
+    cv::Mat output = dst.data == src.data ? cv::Mat() : dst;
+    output.create(maps.imageSize, src.type());
+
+    cv::Size size = output.size();
+    int tilesX = (size.width + kTileWidth - 1) / kTileWidth;
+    int tilesY = (size.height + kTileHeight - 1) / kTileHeight;
+    auto task = [&](size_t index, int) {
+        int tx = static_cast<int>(index) % tilesX;
+        int ty = static_cast<int>(index) / tilesX;
+        cv::Rect tile(tx * kTileWidth, ty * kTileHeight, std::min(kTileWidth, size.width - tx * kTileWidth),
+                      std::min(kTileHeight, size.height - ty * kTileHeight));
+        if (src.channels() == 1) {
+            remapTile<1>(maps, src, output, tile);
+        } else {
+            remapTile<3>(maps, src, output, tile);
+        }
+    };
+
+    size_t tileCount = static_cast<size_t>(tilesX) * tilesY;
+    if (pool) {
+        pool->parallelFor(tileCount, task);
+    } else {
+        for (size_t i = 0; i < tileCount; i++) {
+            task(i, 0);
+        }
+    }
+    dst = output;
+}
+
+void remapImage(const UndistortMaps& maps, const cv::Mat& src, cv::Mat& dst, RemapKernel kernel, ThreadPool* pool) {
+    if (kernel == RemapKernel::Tiled) {
+        remapTiled(maps, src, dst, pool);
+    } else {
+        remapImage(maps, src, dst);
+    }
+}
+
+} // namespace cameracalib
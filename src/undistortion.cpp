@@ -0,0 +1,395 @@
+#include "cameracalib/undistortion.hpp"
+#include "cameracalib/cornerCache.hpp"
+#include "cameracalib/mappedFile.hpp"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace cameracalib {
+
+namespace {
+
+// Map file layout (host byte order): UndistortMapHeader, then map1 and map2 as continuous
+// row-major pixel data. The header is 144 bytes so both maps start suitably aligned for
+// direct use after mmap. Grid maps store the mesh nodes in map1 and have no map2.
+struct UndistortMapHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    int32_t imageWidth;
+    int32_t imageHeight;
+    int32_t map1Type;
+    int32_t map2Type;
+    uint64_t fingerprint;
+    uint64_t map1Bytes;
+    uint64_t map2Bytes;
+    double newCameraMatrix[9];
+    int32_t gridStep;
+    int32_t reserved[3];
+};
+
+static_assert(sizeof(UndistortMapHeader) == 144, "unexpected undistortion map header layout");
+
+const char kUndistortMapMagic[8] = {'C', 'C', 'U', 'N', 'D', 'M', 'A', 'P'};
+const uint32_t kUndistortMapVersion = 2;
+
+// Rows expanded at once when grid maps are applied with cv::remap
+const int kGridStripRows = 64;
+
+size_t matBytes(const cv::Mat& mat) {
+    return mat.empty() ? 0 : mat.total() * mat.elemSize();
+}
+
+// Exact float maps of destination rows [y0, y0 + rows): shifting the principal point of the
+// new camera matrix makes row 0 of the output correspond to row y0
+void buildFloatMapRows(const CalibrationResults& results, const cv::Mat& newCameraMatrix, int width, int y0, int rows,
+                       cv::Mat& mapX, cv::Mat& mapY) {
+    cv::Mat shifted;
+    newCameraMatrix.convertTo(shifted, CV_64F);
+    shifted.at<double>(1, 2) -= y0;
+    cv::initUndistortRectifyMap(results.cameraMatrix, results.distCoeffs, cv::Mat(), shifted,
+                                cv::Size(width, rows), CV_32FC1, mapX, mapY);
+}
+
+// The map types buildUndistortMaps produces for each format; anything else in a file means
+// it is damaged, and an unknown type would make the element size and the view meaningless
+bool validMapTypes(int gridStep, int map1Type, int map2Type) {
+    if (gridStep > 0) {
+        return map1Type == CV_32FC2 && map2Type < 0;
+    }
+    return (map1Type == CV_32FC1 && map2Type == CV_32FC1) || (map1Type == CV_16SC2 && map2Type == CV_16UC1);
+}
+
+} // namespace
+
+cv::Mat optimalNewCameraMatrix(const CalibrationResults& results, const cv::Size& imageSize) {
+    // Refining the camera matrix using parameters obtained by calibration
+    return cv::getOptimalNewCameraMatrix(results.cameraMatrix, results.distCoeffs, imageSize, 1, imageSize, 0);
+}
+
+void undistortImage(const CalibrationResults& results, const cv::Mat& src, cv::Mat& dst) {
+    cv::Mat newCameraMatrix = optimalNewCameraMatrix(results, src.size());
+    cv::undistort(src, dst, results.cameraMatrix, results.distCoeffs, newCameraMatrix);
+}
+
+uint64_t calibrationFingerprint(const CalibrationResults& results, const cv::Size& imageSize) {
+    std::vector<double> values = {static_cast<double>(imageSize.width), static_cast<double>(imageSize.height)};
+    cv::Mat cameraMatrix, distCoeffs;
+    results.cameraMatrix.convertTo(cameraMatrix, CV_64F);
+    results.distCoeffs.convertTo(distCoeffs, CV_64F);
+    for (const cv::Mat& mat : {cameraMatrix, distCoeffs}) {
+        const double* data = mat.ptr<double>(0);
+        values.insert(values.end(), data, data + mat.total());
+    }
+    return hashBytes(reinterpret_cast<const uchar*>(values.data()), values.size() * sizeof(double));
+}
+
+bool parseUndistortMapFormat(const std::string& name, UndistortMapFormat& format) {
+    if (name == "float") {
+        format = UndistortMapFormat::Float;
+    } else if (name == "fixed") {
+        format = UndistortMapFormat::Fixed;
+    } else if (name == "grid") {
+        format = UndistortMapFormat::Grid;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* undistortMapFormatName(UndistortMapFormat format) {
+    switch (format) {
+    case UndistortMapFormat::Fixed:
+        return "fixed";
+    case UndistortMapFormat::Grid:
+        return "grid";
+    default:
+        return "float";
+    }
+}
+
+cv::Size undistortGridSize(const cv::Size& imageSize, int gridStep) {
+    return cv::Size(std::max(2, (imageSize.width + gridStep - 2) / gridStep + 1),
+                    std::max(2, (imageSize.height + gridStep - 2) / gridStep + 1));
+}
+
+void buildUndistortMaps(const CalibrationResults& results, const cv::Size& imageSize, UndistortMaps& maps,
+                        UndistortMapFormat format, UndistortMapAccuracy* accuracy, int gridStep) {
+    maps = UndistortMaps();
+    maps.imageSize = imageSize;
+    maps.fingerprint = calibrationFingerprint(results, imageSize);
+    maps.newCameraMatrix = optimalNewCameraMatrix(results, imageSize);
+
+    if (format == UndistortMapFormat::Grid) {
+        // Scaling the new camera matrix by 1 / gridStep makes output pixel (i, j) the mesh node
+        // at destination pixel (i * gridStep, j * gridStep)
+        cv::Mat gridCameraMatrix;
+        maps.newCameraMatrix.convertTo(gridCameraMatrix, CV_64F);
+        for (int r = 0; r < 2; r++) {
+            for (int c = 0; c < 3; c++) {
+                gridCameraMatrix.at<double>(r, c) /= gridStep;
+            }
+        }
+        cv::Mat nodesX, nodesY;
+        cv::initUndistortRectifyMap(results.cameraMatrix, results.distCoeffs, cv::Mat(), gridCameraMatrix,
+                                    undistortGridSize(imageSize, gridStep), CV_32FC1, nodesX, nodesY);
+        cv::Mat channels[] = {nodesX, nodesY};
+        cv::merge(channels, 2, maps.map1);
+        maps.gridStep = gridStep;
+    } else {
+        cv::initUndistortRectifyMap(results.cameraMatrix, results.distCoeffs, cv::Mat(), maps.newCameraMatrix,
+                                    imageSize, CV_32FC1, maps.map1, maps.map2);
+        if (format == UndistortMapFormat::Fixed) {
+            cv::Mat positions, fractions;
+            cv::convertMaps(maps.map1, maps.map2, positions, fractions, CV_16SC2, false);
+            maps.map1 = positions;
+            maps.map2 = fractions;
+        }
+    }
+
+    if (accuracy) {
+        *accuracy = format == UndistortMapFormat::Float ? UndistortMapAccuracy() : measureUndistortMapAccuracy(results, maps);
+    }
+}
+
+void mapRowPositions(const UndistortMaps& maps, int y, int x0, int count, float* xs, float* ys) {
+    switch (maps.format()) {
+    case UndistortMapFormat::Float:
+        {
+            const float* mapX = maps.map1.ptr<float>(y) + x0;
+            const float* mapY = maps.map2.ptr<float>(y) + x0;
+            std::copy(mapX, mapX + count, xs);
+            std::copy(mapY, mapY + count, ys);
+        }
+        break;
+    case UndistortMapFormat::Fixed:
+        {
+            // remap interpolates fixed-point maps on a 1/INTER_TAB_SIZE grid: x = integer x + (fraction % 32) / 32,
+            // y = integer y + (fraction / 32) / 32
+            const float step = 1.0f / cv::INTER_TAB_SIZE;
+            const short* positions = maps.map1.ptr<short>(y) + 2 * x0;
+            const ushort* fractions = maps.map2.ptr<ushort>(y) + x0;
+            for (int i = 0; i < count; i++) {
+                xs[i] = positions[2 * i] + (fractions[i] & (cv::INTER_TAB_SIZE - 1)) * step;
+                ys[i] = positions[2 * i + 1] + (fractions[i] >> cv::INTER_BITS) * step;
+            }
+        }
+        break;
+    case UndistortMapFormat::Grid:
+        {
+            // Bilinear interpolation between the four mesh nodes around each pixel
+            const int step = maps.gridStep;
+            const float inverseStep = 1.0f / step;
+            int row = std::min(y / step, maps.map1.rows - 2);
+            float ty = (y - row * step) * inverseStep;
+            const float* top = maps.map1.ptr<float>(row);
+            const float* bottom = maps.map1.ptr<float>(row + 1);
+            int lastColumn = maps.map1.cols - 2;
+            for (int i = 0; i < count; i++) {
+                int x = x0 + i;
+                int column = std::min(x / step, lastColumn);
+                float tx = (x - column * step) * inverseStep;
+                const float* t = top + 2 * column;
+                const float* b = bottom + 2 * column;
+                float leftX = t[0] + (b[0] - t[0]) * ty, rightX = t[2] + (b[2] - t[2]) * ty;
+                float leftY = t[1] + (b[1] - t[1]) * ty, rightY = t[3] + (b[3] - t[3]) * ty;
+                xs[i] = leftX + (rightX - leftX) * tx;
+                ys[i] = leftY + (rightY - leftY) * tx;
+            }
+        }
+        break;
+    }
+}
+
+UndistortMapAccuracy measureUndistortMapAccuracy(const CalibrationResults& results, const UndistortMaps& maps) {
+    UndistortMapAccuracy accuracy;
+    const cv::Size& size = maps.imageSize;
+    std::vector<float> xs(size.width), ys(size.width);
+    double totalError = 0.0;
+    cv::Mat exactX, exactY;
+    for (int y0 = 0; y0 < size.height; y0 += kGridStripRows) {
+        int rows = std::min(kGridStripRows, size.height - y0);
+        buildFloatMapRows(results, maps.newCameraMatrix, size.width, y0, rows, exactX, exactY);
+        for (int r = 0; r < rows; r++) {
+            mapRowPositions(maps, y0 + r, 0, size.width, xs.data(), ys.data());
+            const float* mapX = exactX.ptr<float>(r);
+            const float* mapY = exactY.ptr<float>(r);
+            for (int x = 0; x < size.width; x++) {
+                double error = std::hypot(static_cast<double>(xs[x]) - mapX[x], static_cast<double>(ys[x]) - mapY[x]);
+                accuracy.maxError = std::max(accuracy.maxError, error);
+                totalError += error;
+            }
+        }
+    }
+    size_t pixels = static_cast<size_t>(size.area());
+    accuracy.meanError = pixels > 0 ? totalError / pixels : 0.0;
+    return accuracy;
+}
+
+void remapImage(const UndistortMaps& maps, const cv::Mat& src, cv::Mat& dst) {
+    if (maps.format() != UndistortMapFormat::Grid) {
+        cv::remap(src, dst, maps.map1, maps.map2, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+        return;
+    }
+
+    // Writing into src in place would corrupt later strips
+    cv::Mat output = dst.data == src.data ? cv::Mat() : dst;
+    output.create(maps.imageSize, src.type());
+    cv::Mat stripX, stripY;
+    for (int y0 = 0; y0 < maps.imageSize.height; y0 += kGridStripRows) {
+        int rows = std::min(kGridStripRows, maps.imageSize.height - y0);
+        stripX.create(rows, maps.imageSize.width, CV_32FC1);
+        stripY.create(rows, maps.imageSize.width, CV_32FC1);
+        for (int r = 0; r < rows; r++) {
+            mapRowPositions(maps, y0 + r, 0, maps.imageSize.width, stripX.ptr<float>(r), stripY.ptr<float>(r));
+        }
+        cv::Mat strip = output.rowRange(y0, y0 + rows);
+        cv::remap(src, strip, stripX, stripY, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+    }
+    dst = output;
+}
+
+std::string undistortMapPath(const std::string& calibrationFile) {
+    return std::filesystem::path(calibrationFile).replace_extension(".maps").string();
+}
+
+size_t undistortMapsBytes(const UndistortMaps& maps) {
+    return sizeof(UndistortMapHeader) + matBytes(maps.map1) + matBytes(maps.map2);
+}
+
+bool writeUndistortMaps(std::ostream& out, const UndistortMaps& maps) {
+    UndistortMapHeader header = {};
+    std::memcpy(header.magic, kUndistortMapMagic, sizeof(header.magic));
+    header.version = kUndistortMapVersion;
+    header.byteOrderMark = kByteOrderMark;
+    header.imageWidth = maps.imageSize.width;
+    header.imageHeight = maps.imageSize.height;
+    header.map1Type = maps.map1.type();
+    header.map2Type = maps.map2.empty() ? -1 : maps.map2.type();
+    header.fingerprint = maps.fingerprint;
+    header.map1Bytes = matBytes(maps.map1);
+    header.map2Bytes = matBytes(maps.map2);
+    cv::Mat newCameraMatrix;
+    maps.newCameraMatrix.convertTo(newCameraMatrix, CV_64F);
+    std::memcpy(header.newCameraMatrix, newCameraMatrix.ptr<double>(0), sizeof(header.newCameraMatrix));
+    header.gridStep = maps.gridStep;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const cv::Mat& map : {maps.map1, maps.map2}) {
+        if (map.empty()) {
+            continue;
+        }
+        cv::Mat continuous = map.isContinuous() ? map : map.clone();
+        out.write(reinterpret_cast<const char*>(continuous.ptr(0)), matBytes(continuous));
+    }
+    return static_cast<bool>(out);
+}
+
+bool saveUndistortMaps(const UndistortMaps& maps, const std::string& mapFile) {
+    std::string tempPath = mapFile + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write to undistortion map file " << mapFile << std::endl;
+        return false;
+    }
+
+    writeUndistortMaps(file, maps);
+
+    file.close();
+    std::error_code renameError;
+    if (file) {
+        std::filesystem::rename(tempPath, mapFile, renameError);
+    }
+    if (!file || renameError) {
+        std::remove(tempPath.c_str());
+        std::cerr << "Error: Could not write to undistortion map file " << mapFile << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool viewUndistortMaps(const std::shared_ptr<MappedFile>& storage, size_t offset, size_t size, uint64_t fingerprint,
+                       UndistortMaps& maps) {
+    if (offset > storage->size() || size > storage->size() - offset || size < sizeof(UndistortMapHeader)) {
+        return false;
+    }
+
+    UndistortMapHeader header;
+    std::memcpy(&header, storage->data() + offset, sizeof(header));
+    if (std::memcmp(header.magic, kUndistortMapMagic, sizeof(header.magic)) != 0 || header.version != kUndistortMapVersion ||
+        header.byteOrderMark != kByteOrderMark || header.fingerprint != fingerprint ||
+        header.imageWidth <= 0 || header.imageHeight <= 0 || header.gridStep < 0 ||
+        size != sizeof(header) + header.map1Bytes + header.map2Bytes) {
+        return false;
+    }
+
+    if (!validMapTypes(header.gridStep, header.map1Type, header.map2Type)) {
+        return false;
+    }
+
+    cv::Size imageSize(header.imageWidth, header.imageHeight);
+    cv::Size mapSize = header.gridStep > 0 ? undistortGridSize(imageSize, header.gridStep) : imageSize;
+    size_t pixels = static_cast<size_t>(mapSize.area());
+    if (header.map1Bytes != pixels * CV_ELEM_SIZE(header.map1Type) ||
+        (header.map2Type >= 0 ? header.map2Bytes != pixels * CV_ELEM_SIZE(header.map2Type) : header.map2Bytes != 0)) {
+        return false;
+    }
+
+    // The maps are only ever read, so they can point straight into the read-only mapping
+    uchar* data = const_cast<uchar*>(storage->data()) + offset + sizeof(header);
+    maps = UndistortMaps();
+    maps.imageSize = imageSize;
+    maps.fingerprint = header.fingerprint;
+    maps.newCameraMatrix = cv::Mat(3, 3, CV_64F, header.newCameraMatrix).clone();
+    maps.map1 = cv::Mat(mapSize, header.map1Type, data);
+    if (header.map2Type >= 0) {
+        maps.map2 = cv::Mat(mapSize, header.map2Type, data + header.map1Bytes);
+    }
+    maps.gridStep = header.gridStep;
+    maps.storage = storage;
+    return true;
+}
+
+bool loadUndistortMaps(const std::string& mapFile, uint64_t fingerprint, UndistortMaps& maps) {
+    std::shared_ptr<MappedFile> storage(new MappedFile());
+    if (!storage->open(mapFile)) {
+        return false;
+    }
+    return viewUndistortMaps(storage, 0, storage->size(), fingerprint, maps);
+}
+
+bool loadOrBuildUndistortMaps(const CalibrationResults& results, const cv::Size& imageSize,
+                              const std::string& mapFile, UndistortMaps& maps, UndistortMapFormat format, int gridStep) {
+    uint64_t fingerprint = calibrationFingerprint(results, imageSize);
+    if (!mapFile.empty() && loadUndistortMaps(mapFile, fingerprint, maps) && maps.format() == format &&
+        (format != UndistortMapFormat::Grid || maps.gridStep == gridStep)) {
+        std::cout << "Loaded " << undistortMapFormatName(format) << " undistortion maps from: " << mapFile << std::endl;
+        return true;
+    }
+
+    UndistortMapAccuracy accuracy;
+    buildUndistortMaps(results, imageSize, maps, format, &accuracy, gridStep);
+    if (format != UndistortMapFormat::Float) {
+        std::cout << "Undistortion maps (" << undistortMapFormatName(format) << ", "
+                  << (matBytes(maps.map1) + matBytes(maps.map2)) / 1024 << " KB): max position error " << accuracy.maxError
+                  << " px, mean " << accuracy.meanError << " px vs float maps" << std::endl;
+    }
+    if (mapFile.empty()) {
+        return true;
+    }
+    if (!saveUndistortMaps(maps, mapFile)) {
+        return false;
+    }
+    std::cout << "Undistortion maps saved to: " << mapFile << std::endl;
+    return true;
+}
+
+} // namespace cameracalib
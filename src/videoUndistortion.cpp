@@ -0,0 +1,199 @@
+#include "cameracalib/videoUndistortion.hpp"
+#include "cameracalib/boundedQueue.hpp"
+
+#include <opencv2/videoio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cameracalib {
+
+namespace {
+
+struct FrameSlot {
+    cv::Mat input;
+    cv::Mat output;
+    std::chrono::steady_clock::time_point decodeStart;
+};
+
+// Passed down the queues after the last frame
+const int kEndOfStream = -1;
+
+bool pushSlot(BoundedQueue<int>& queue, int slot, const std::atomic<bool>& stop) {
+    int attempt = 0;
+    while (!queue.tryPush(slot)) {
+        if (stop) {
+            return false;
+        }
+        waitBackoff(attempt);
+    }
+    return true;
+}
+
+bool popSlot(BoundedQueue<int>& queue, int& slot, const std::atomic<bool>& stop) {
+    int attempt = 0;
+    while (!queue.tryPop(slot)) {
+        if (stop) {
+            return false;
+        }
+        waitBackoff(attempt);
+    }
+    return true;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+} // namespace
+
+bool undistortVideo(const UndistortMaps& maps, const std::string& inputFile, const std::string& outputFile,
+                    const VideoUndistortOptions& options, VideoUndistortStats& stats) {
+    stats = VideoUndistortStats();
+
+    cv::VideoCapture capture(inputFile);
+    if (!capture.isOpened()) {
+        std::cerr << "Error: Could not open video " << inputFile << std::endl;
+        return false;
+    }
+
+    cv::Size frameSize(static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    if (frameSize != maps.imageSize) {
+        std::cerr << "Error: Video frames are " << frameSize << " but the calibration is for " << maps.imageSize << std::endl;
+        return false;
+    }
+
+    double fps = capture.get(cv::CAP_PROP_FPS);
+    if (fps <= 0.0) {
+        fps = 30.0;
+    }
+    int fourcc = static_cast<int>(capture.get(cv::CAP_PROP_FOURCC));
+    if (options.fourcc.size() == 4) {
+        fourcc = cv::VideoWriter::fourcc(options.fourcc[0], options.fourcc[1], options.fourcc[2], options.fourcc[3]);
+    }
+
+    cv::VideoWriter writer;
+    if (!writer.open(outputFile, fourcc, fps, frameSize, true)) {
+        std::cerr << "Error: Could not open " << outputFile << " for writing; try another --fourcc." << std::endl;
+        return false;
+    }
+
+    // The ring: every slot is either free, decoded or remapped. Queues get one extra cell for
+    // the end-of-stream marker.
+    size_t ringSize = std::max<size_t>(3, options.ringSize);
+    std::vector<FrameSlot> slots(ringSize);
+    BoundedQueue<int> freeSlots(ringSize + 1);
+    BoundedQueue<int> decoded(ringSize + 1);
+    BoundedQueue<int> remapped(ringSize + 1);
+    for (size_t i = 0; i < ringSize; i++) {
+        int slot = static_cast<int>(i);
+        freeSlots.tryPush(slot);
+    }
+
+    std::atomic<bool> stop(false);
+    std::mutex errorMutex;
+    std::string error;
+    auto fail = [&](const std::string& message) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (error.empty()) {
+            error = message;
+        }
+        stop = true;
+    };
+
+    double expectedFrames = capture.get(cv::CAP_PROP_FRAME_COUNT);
+    std::vector<double> latencies;
+    latencies.reserve(expectedFrames > 0 ? static_cast<size_t>(expectedFrames) : 0);
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread decodeThread([&]() {
+        try {
+            int slot;
+            while (popSlot(freeSlots, slot, stop)) {
+                FrameSlot& frame = slots[slot];
+                frame.decodeStart = std::chrono::steady_clock::now();
+                bool read = capture.read(frame.input);
+                stats.decodeMs += elapsedMs(frame.decodeStart);
+                if (!read || frame.input.empty()) {
+                    break;
+                }
+                if (frame.input.size() != frameSize) {
+                    fail("video frame size changed mid-stream");
+                    return;
+                }
+                if (!pushSlot(decoded, slot, stop)) {
+                    return;
+                }
+            }
+        } catch (const cv::Exception& e) {
+            fail(std::string("decoding failed: ") + e.what());
+        }
+        pushSlot(decoded, kEndOfStream, stop);
+    });
+
+    std::thread remapThread([&]() {
+        try {
+            int slot;
+            while (popSlot(decoded, slot, stop) && slot != kEndOfStream) {
+                FrameSlot& frame = slots[slot];
+                auto remapStart = std::chrono::steady_clock::now();
+                remapImage(maps, frame.input, frame.output, options.remapKernel, options.pool);
+                stats.remapMs += elapsedMs(remapStart);
+                if (!pushSlot(remapped, slot, stop)) {
+                    return;
+                }
+            }
+        } catch (const cv::Exception& e) {
+            fail(std::string("remapping failed: ") + e.what());
+        }
+        pushSlot(remapped, kEndOfStream, stop);
+    });
+
+    // Encoding runs on the calling thread
+    try {
+        int slot;
+        while (popSlot(remapped, slot, stop) && slot != kEndOfStream) {
+            FrameSlot& frame = slots[slot];
+            auto encodeStart = std::chrono::steady_clock::now();
+            writer.write(frame.output);
+            stats.encodeMs += elapsedMs(encodeStart);
+            latencies.push_back(elapsedMs(frame.decodeStart));
+            if (!pushSlot(freeSlots, slot, stop)) {
+                break;
+            }
+        }
+    } catch (const cv::Exception& e) {
+        fail(std::string("encoding failed: ") + e.what());
+    }
+
+    decodeThread.join();
+    remapThread.join();
+    writer.release();
+
+    stats.frames = latencies.size();
+    stats.seconds = elapsedMs(start) / 1000.0;
+    stats.fps = stats.seconds > 0.0 ? stats.frames / stats.seconds : 0.0;
+    stats.latency = computeTimingStats(latencies);
+
+    if (!error.empty()) {
+        std::cerr << "Error: Video undistortion of " << inputFile << " stopped, " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void printVideoUndistortStats(const VideoUndistortStats& stats) {
+    std::cout << "Undistorted " << stats.frames << " frame(s) in " << stats.seconds << " s (" << stats.fps << " fps)" << std::endl;
+    std::cout << "  Latency per frame: mean " << stats.latency.meanMs << " ms, p50 " << stats.latency.p50Ms << " ms, p95 "
+              << stats.latency.p95Ms << " ms, max " << stats.latency.maxMs << " ms" << std::endl;
+    std::cout << "  Busy time: decode " << stats.decodeMs << " ms, remap " << stats.remapMs << " ms, encode "
+              << stats.encodeMs << " ms" << std::endl;
+}
+
+} // namespace cameracalib
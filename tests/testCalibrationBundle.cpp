@@ -0,0 +1,137 @@
+#include "testing.hpp"
+
+#include "cameracalib/calibrationBundle.hpp"
+#include "cameracalib/undistortion.hpp"
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace cameracalib;
+
+namespace {
+
+// Offsets into the bundle header: magic (8), version, byte order mark, eight int32 fields,
+// the mean reprojection error and the fingerprint come before the maps section
+const std::streamoff kMapsOffsetField = 64;
+const std::streamoff kMapsBytesField = 72;
+
+CalibrationResults testCalibration() {
+    CalibrationResults results;
+    results.cameraMatrix = (cv::Mat_<double>(3, 3) << 520.125, 0.0, 322.5, 0.0, 515.0 / 3.0, 236.0, 0.0, 0.0, 1.0);
+    results.distCoeffs = (cv::Mat_<double>(5, 1) << -0.28, 0.09, 0.0012, -0.0008, -0.01);
+    for (int i = 0; i < 4; i++) {
+        results.rvecs.push_back((cv::Mat_<double>(3, 1) << 0.1 * i, -0.2, 1.0 / (i + 3)));
+        results.tvecs.push_back((cv::Mat_<double>(3, 1) << -3.0, 2.5 * i, 25.0 + i / 7.0));
+    }
+    results.success = true;
+    results.imageSize = cv::Size(640, 480);
+    results.checkerboardSize = cv::Size(7, 10);
+    results.numImagesUsed = 4;
+    results.meanReprojectionError = 0.123456789;
+    return results;
+}
+
+bool identical(const cv::Mat& a, const cv::Mat& b) {
+    return a.type() == b.type() && a.size() == b.size() && cv::norm(a, b, cv::NORM_INF) == 0.0;
+}
+
+void patchUint64(const std::string& path, std::streamoff offset, uint64_t value) {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+} // namespace
+
+TEST_CASE(bundleRoundTripKeepsParametersAndMaps) {
+    testing::TempDir dir;
+    CalibrationResults results = testCalibration();
+    UndistortMaps maps;
+    buildUndistortMaps(results, results.imageSize, maps, UndistortMapFormat::Fixed);
+    CHECK(saveCalibrationBundle(results, &maps, dir.file("camera.calib")));
+    CHECK(isCalibrationBundle(dir.file("camera.calib")));
+
+    CalibrationResults loaded;
+    UndistortMaps loadedMaps;
+    CHECK(loadCalibrationBundle(dir.file("camera.calib"), loaded, &loadedMaps));
+    CHECK(identical(loaded.cameraMatrix, results.cameraMatrix));
+    CHECK(identical(loaded.distCoeffs, results.distCoeffs));
+    CHECK(loaded.rvecs.size() == results.rvecs.size() && loaded.tvecs.size() == results.tvecs.size());
+    for (size_t i = 0; i < loaded.rvecs.size() && i < results.rvecs.size(); i++) {
+        CHECK(identical(loaded.rvecs[i], results.rvecs[i]));
+        CHECK(identical(loaded.tvecs[i], results.tvecs[i]));
+    }
+    CHECK(loaded.success && loaded.imageSize == results.imageSize && loaded.checkerboardSize == results.checkerboardSize);
+    CHECK(loaded.numImagesUsed == results.numImagesUsed);
+    CHECK(loaded.meanReprojectionError == results.meanReprojectionError);
+
+    CHECK(loadedMaps.format() == UndistortMapFormat::Fixed);
+    CHECK(identical(loadedMaps.map1, maps.map1));
+    CHECK(identical(loadedMaps.map2, maps.map2));
+
+    // Without maps the bundle holds only the parameters
+    CHECK(saveCalibrationBundle(results, nullptr, dir.file("plain.calib")));
+    CHECK(loadCalibrationBundle(dir.file("plain.calib"), loaded, &loadedMaps));
+    CHECK(loadedMaps.empty());
+}
+
+TEST_CASE(corruptBundlesAreRejected) {
+    testing::TempDir dir;
+    CalibrationResults results = testCalibration();
+    UndistortMaps maps;
+    buildUndistortMaps(results, results.imageSize, maps, UndistortMapFormat::Float);
+    std::string original = dir.file("camera.calib");
+    CHECK(saveCalibrationBundle(results, &maps, original));
+    uintmax_t size = std::filesystem::file_size(original);
+    CalibrationResults loaded;
+
+    std::string truncated = dir.file("truncated.calib");
+    std::filesystem::copy_file(original, truncated);
+    std::filesystem::resize_file(truncated, 100);
+    CHECK(!loadCalibrationBundle(truncated, loaded));
+
+    // Maps claimed to start inside the header and parameters, with a size that matches
+    // the rest of the file
+    std::string overlapping = dir.file("overlapping.calib");
+    std::filesystem::copy_file(original, overlapping);
+    patchUint64(overlapping, kMapsOffsetField, 64);
+    patchUint64(overlapping, kMapsBytesField, size - 64);
+    CHECK(!loadCalibrationBundle(overlapping, loaded));
+
+    // A changed parameter no longer matches the fingerprint
+    std::string changed = dir.file("changed.calib");
+    std::filesystem::copy_file(original, changed);
+    {
+        std::fstream file(changed, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(160);
+        file.put('\x42');
+    }
+    CHECK(!loadCalibrationBundle(changed, loaded));
+
+    CHECK(!loadCalibrationBundle(dir.file("does_not_exist.calib"), loaded));
+    CHECK(loadCalibrationBundle(original, loaded));
+}
+
+TEST_CASE(incompleteResultsAreNotSaved) {
+    testing::TempDir dir;
+    CalibrationResults noDistortion = testCalibration();
+    noDistortion.distCoeffs.release();
+    CHECK(!saveCalibrationBundle(noDistortion, nullptr, dir.file("a.calib")));
+
+    CalibrationResults shortVector = testCalibration();
+    shortVector.tvecs[2] = (cv::Mat_<double>(2, 1) << 1.0, 2.0);
+    CHECK(!saveCalibrationBundle(shortVector, nullptr, dir.file("b.calib")));
+
+    CalibrationResults unpaired = testCalibration();
+    unpaired.rvecs.pop_back();
+    CHECK(!saveCalibrationBundle(unpaired, nullptr, dir.file("c.calib")));
+
+    CHECK(!std::filesystem::exists(dir.file("a.calib")));
+    CHECK(!std::filesystem::exists(dir.file("b.calib")));
+    CHECK(!std::filesystem::exists(dir.file("c.calib")));
+}
+
+TEST_MAIN
@@ -0,0 +1,113 @@
+#include "testing.hpp"
+
+#include "cameracalib/calibration.hpp"
+
+#include <opencv2/core.hpp>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace cameracalib;
+
+namespace {
+
+// Exact comparison of the bits, so that e.g. -0.0 and 0.0 differ
+bool sameBits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+bool sameDoubles(const cv::Mat& a, const cv::Mat& b) {
+    cv::Mat a64, b64;
+    a.convertTo(a64, CV_64F);
+    b.convertTo(b64, CV_64F);
+    if (a64.total() != b64.total()) {
+        return false;
+    }
+    a64 = a64.reshape(1, 1).clone();
+    b64 = b64.reshape(1, 1).clone();
+    for (size_t i = 0; i < a64.total(); i++) {
+        if (!sameBits(a64.at<double>(static_cast<int>(i)), b64.at<double>(static_cast<int>(i)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+CalibrationResults awkwardResults() {
+    CalibrationResults results;
+    results.cameraMatrix = (cv::Mat_<double>(3, 3) << 1234.5678901234567, 0.0, 640.1 / 3.0,
+                            0.0, std::nextafter(1234.5, 2000.0), 479.99999999999994, 0.0, 0.0, 1.0);
+    results.distCoeffs = (cv::Mat_<double>(5, 1) << -0.1, 1e-300, -DBL_MIN, 1.0 / 7.0, -0.0);
+
+    // A float rotation vector and a translation vector that is a non-continuous column
+    // exercise the conversion path of the writer
+    results.rvecs.push_back((cv::Mat_<float>(3, 1) << 0.1f, -0.2f, 3.1415927f));
+    results.rvecs.push_back((cv::Mat_<double>(3, 1) << DBL_MAX, -1e-307, 2.0 / 3.0));
+    cv::Mat poses = (cv::Mat_<double>(3, 2) << 10.25, 1.0 / 9.0, -20.5, 1e22, 1000.000001, -1e-22);
+    results.tvecs.push_back(poses.col(0));
+    results.tvecs.push_back(poses.col(1));
+
+    results.success = true;
+    results.imageSize = cv::Size(1280, 960);
+    results.checkerboardSize = cv::Size(7, 10);
+    results.numImagesUsed = 2;
+    results.meanReprojectionError = 0.1 + 0.2;
+    return results;
+}
+
+} // namespace
+
+TEST_CASE(jsonRoundTripIsBitExact) {
+    testing::TempDir dir;
+    CalibrationResults results = awkwardResults();
+    CHECK(saveCalibrationResultsToJSON(results, dir.file("calibration.json")));
+
+    CalibrationResults loaded;
+    CHECK(loadCalibrationResultsFromJSON(dir.file("calibration.json"), loaded));
+    CHECK(sameDoubles(loaded.cameraMatrix, results.cameraMatrix));
+    CHECK(sameDoubles(loaded.distCoeffs, results.distCoeffs));
+    CHECK(loaded.rvecs.size() == 2 && loaded.tvecs.size() == 2);
+    for (size_t i = 0; i < loaded.rvecs.size() && i < 2; i++) {
+        CHECK(sameDoubles(loaded.rvecs[i], results.rvecs[i]));
+        CHECK(sameDoubles(loaded.tvecs[i], results.tvecs[i]));
+    }
+    CHECK(loaded.success);
+    CHECK(loaded.imageSize == results.imageSize);
+    CHECK(loaded.checkerboardSize == results.checkerboardSize);
+    CHECK(loaded.numImagesUsed == results.numImagesUsed);
+    CHECK(sameBits(loaded.meanReprojectionError, results.meanReprojectionError));
+
+    // Saving what was loaded reproduces the file byte for byte
+    CHECK(saveCalibrationResultsToJSON(loaded, dir.file("again.json")));
+    std::ifstream first(dir.file("calibration.json"), std::ios::binary);
+    std::ifstream second(dir.file("again.json"), std::ios::binary);
+    std::string firstText((std::istreambuf_iterator<char>(first)), std::istreambuf_iterator<char>());
+    std::string secondText((std::istreambuf_iterator<char>(second)), std::istreambuf_iterator<char>());
+    CHECK(!firstText.empty() && firstText == secondText);
+}
+
+TEST_CASE(emptyDistortionIsWrittenButNotLoaded) {
+    testing::TempDir dir;
+    CalibrationResults results = awkwardResults();
+    results.distCoeffs.release();
+    CHECK(saveCalibrationResultsToJSON(results, dir.file("calibration.json")));
+
+    CalibrationResults loaded;
+    CHECK(!loadCalibrationResultsFromJSON(dir.file("calibration.json"), loaded));
+}
+
+TEST_CASE(damagedJsonIsRejected) {
+    testing::TempDir dir;
+    std::string path = dir.file("calibration.json");
+    CHECK(saveCalibrationResultsToJSON(awkwardResults(), path));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+
+    CalibrationResults loaded;
+    CHECK(!loadCalibrationResultsFromJSON(path, loaded));
+    CHECK(!loadCalibrationResultsFromJSON(dir.file("does_not_exist.json"), loaded));
+}
+
+TEST_MAIN
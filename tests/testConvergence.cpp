@@ -0,0 +1,122 @@
+#include "testing.hpp"
+
+#include "cameracalib/convergence.hpp"
+#include "cameracalib/synthetic.hpp"
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <vector>
+
+using namespace cameracalib;
+
+namespace {
+
+// Exact corners of numViews synthetic poses with 0.05 px of detection noise
+CornerSet syntheticCorners(int numViews) {
+    SyntheticOptions options;
+    options.imageSize = cv::Size(640, 480);
+    options.numViews = numViews;
+    options.distortion = {-0.2, 0.05, 0.0, 0.0, 0.0};
+    std::vector<SyntheticView> views;
+    CHECK(generateSyntheticPoses(options, views));
+
+    CornerSet corners;
+    corners.imageSize = options.imageSize;
+    corners.checkerboardSize = options.checkerboardSize;
+    cv::RNG rng(3);
+    for (SyntheticView& view : views) {
+        for (cv::Point2f& corner : view.corners) {
+            corner.x += static_cast<float>(rng.gaussian(0.05));
+            corner.y += static_cast<float>(rng.gaussian(0.05));
+        }
+        corners.imgpoints.push_back(view.corners);
+    }
+    return corners;
+}
+
+CornerSet firstViews(const CornerSet& corners, size_t count) {
+    CornerSet prefix;
+    prefix.imageSize = corners.imageSize;
+    prefix.checkerboardSize = corners.checkerboardSize;
+    prefix.imgpoints.assign(corners.imgpoints.begin(), corners.imgpoints.begin() + count);
+    return prefix;
+}
+
+} // namespace
+
+TEST_CASE(interleavedOrderSpreadsEveryPrefix) {
+    for (size_t count : {size_t(0), size_t(1), size_t(2), size_t(5), size_t(64), size_t(100)}) {
+        std::vector<size_t> order = interleavedOrder(count);
+        std::vector<size_t> sorted = order;
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<size_t> expected(count);
+        for (size_t i = 0; i < count; i++) {
+            expected[i] = i;
+        }
+        CHECK(sorted == expected);
+    }
+
+    // With a power of two every prefix of 2^k images has one image in each of 2^k equal blocks
+    std::vector<size_t> order = interleavedOrder(64);
+    for (size_t prefix = 1; prefix <= 64; prefix *= 2) {
+        std::vector<bool> blockSeen(prefix, false);
+        for (size_t i = 0; i < prefix; i++) {
+            size_t block = order[i] / (64 / prefix);
+            CHECK(!blockSeen[block]);
+            blockSeen[block] = true;
+        }
+    }
+    CHECK(order[0] == 0 && order[1] == 32 && order[2] == 16 && order[3] == 48);
+}
+
+TEST_CASE(monitorWaitsForMinViews) {
+    ConvergenceOptions options;
+    options.minViews = 8;
+    ConvergenceMonitor monitor(options);
+    CornerSet corners = syntheticCorners(8);
+    CHECK(!monitor.update(firstViews(corners, 7), 7));
+    CHECK(monitor.checks().empty());
+    CHECK(!monitor.update(corners, 8));
+    CHECK(monitor.checks().size() == 1);
+    CHECK(!monitor.checks()[0].compared);
+}
+
+TEST_CASE(monitorStopsOnceTrialSolvesAgree) {
+    ConvergenceOptions options;
+    options.minViews = 6;
+    options.stableChecks = 2;
+    ConvergenceMonitor monitor(options);
+    CornerSet corners = syntheticCorners(60);
+
+    size_t stoppedAt = 0;
+    for (size_t views = 6; views <= corners.imgpoints.size(); views += 6) {
+        if (monitor.update(firstViews(corners, views), views)) {
+            stoppedAt = views;
+            break;
+        }
+    }
+    CHECK(stoppedAt > 0 && stoppedAt < corners.imgpoints.size());
+    CHECK(monitor.converged());
+
+    // The last stableChecks solves were within the tolerances, and the first one had
+    // nothing to compare against
+    const std::vector<ConvergenceCheck>& checks = monitor.checks();
+    CHECK(checks.size() >= 3);
+    CHECK(!checks.front().compared && !checks.front().stable);
+    for (size_t i = checks.size() - 2; i < checks.size(); i++) {
+        CHECK(checks[i].stable);
+        CHECK(checks[i].intrinsicsChange <= options.intrinsicsTolerance);
+        CHECK(checks[i].errorChange <= options.errorTolerance);
+    }
+
+    // Tolerances nothing can meet never stop the ingestion
+    ConvergenceOptions strict = options;
+    strict.errorTolerance = -1.0;
+    ConvergenceMonitor never(strict);
+    for (size_t views = 6; views <= 30; views += 6) {
+        CHECK(!never.update(firstViews(corners, views), views));
+    }
+    CHECK(!never.converged());
+}
+
+TEST_MAIN
@@ -0,0 +1,187 @@
+#include "testing.hpp"
+
+#include "cameracalib/cornerCache.hpp"
+#include "cameracalib/detection.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace cameracalib;
+
+namespace {
+
+void writeBytes(const std::string& path, const std::vector<uchar>& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+CornerCacheKey keyFor(const std::string& path, const cv::Size& board, uint32_t flags) {
+    std::vector<uchar> bytes;
+    CornerCacheKey key;
+    CHECK(readFileBytes(path, bytes));
+    CHECK(CornerCache::makeKey(path, bytes, board, flags, key));
+    return key;
+}
+
+ImageDetection foundDetection(int count) {
+    ImageDetection detection;
+    detection.imageRead = true;
+    detection.found = true;
+    detection.imageSize = cv::Size(640, 480);
+    for (int i = 0; i < count; i++) {
+        detection.corners.push_back(cv::Point2f(10.25f + i, 20.5f + 2 * i));
+    }
+    return detection;
+}
+
+} // namespace
+
+TEST_CASE(keyDependsOnContentBoardAndSettings) {
+    testing::TempDir dir;
+    std::string image = dir.file("view.png");
+    writeBytes(image, std::vector<uchar>(1000, 7));
+    uint32_t flags = detectionCacheFlags(DetectionOptions());
+
+    CornerCacheKey key = keyFor(image, cv::Size(7, 10), flags);
+    CHECK(key == keyFor(image, cv::Size(7, 10), flags));
+    CHECK(!(key == keyFor(image, cv::Size(10, 7), flags)));
+
+    DetectionOptions gray;
+    gray.decodeMode = DecodeMode::Gray;
+    DetectionOptions pyramid;
+    pyramid.pyramid = true;
+    DetectionOptions sectorBased;
+    sectorBased.detector = DetectorBackend::SectorBased;
+    CHECK(detectionCacheFlags(gray) != flags);
+    CHECK(detectionCacheFlags(pyramid) != flags);
+    CHECK(detectionCacheFlags(sectorBased) != flags);
+
+    std::vector<uchar> changed(1000, 7);
+    changed[500] = 8;
+    writeBytes(image, changed);
+    CHECK(keyFor(image, cv::Size(7, 10), flags).contentHash != key.contentHash);
+}
+
+TEST_CASE(entriesSurviveSaveAndLoad) {
+    testing::TempDir dir;
+    std::string image = dir.file("view.png");
+    std::string other = dir.file("other.png");
+    writeBytes(image, std::vector<uchar>(333, 1));
+    writeBytes(other, std::vector<uchar>(333, 2));
+    uint32_t flags = detectionCacheFlags(DetectionOptions());
+    CornerCacheKey foundKey = keyFor(image, cv::Size(7, 10), flags);
+    CornerCacheKey notFoundKey = keyFor(other, cv::Size(7, 10), flags);
+
+    ImageDetection found = foundDetection(70);
+    ImageDetection notFound;
+    notFound.imageRead = true;
+    notFound.imageSize = cv::Size(640, 480);
+
+    CornerCache cache;
+    CHECK(!cache.dirty());
+    cache.store(foundKey, found);
+    cache.store(notFoundKey, notFound);
+    CHECK(cache.dirty());
+    CHECK(cache.save(dir.file("corners.cache")));
+    CHECK(!cache.dirty());
+
+    CornerCache loaded;
+    CHECK(loaded.load(dir.file("corners.cache")));
+    CHECK(loaded.size() == 2);
+
+    ImageDetection detection;
+    CHECK(loaded.lookup(foundKey, detection));
+    CHECK(detection.imageRead && detection.found);
+    CHECK(detection.imageSize == found.imageSize);
+    CHECK(detection.corners == found.corners);
+
+    ImageDetection missing;
+    CHECK(loaded.lookup(notFoundKey, missing));
+    CHECK(missing.imageRead && !missing.found && missing.corners.empty());
+    CHECK(loaded.hits() == 2 && loaded.misses() == 0);
+}
+
+TEST_CASE(changedImageOrSettingsMiss) {
+    testing::TempDir dir;
+    std::string image = dir.file("view.png");
+    writeBytes(image, std::vector<uchar>(256, 3));
+    uint32_t flags = detectionCacheFlags(DetectionOptions());
+    CornerCacheKey key = keyFor(image, cv::Size(7, 10), flags);
+
+    CornerCache cache;
+    cache.store(key, foundDetection(70));
+
+    ImageDetection detection;
+    CHECK(!cache.lookup(keyFor(image, cv::Size(7, 10), flags ^ 1u), detection));
+    CHECK(!cache.lookup(keyFor(image, cv::Size(6, 10), flags), detection));
+
+    std::vector<uchar> changed(256, 3);
+    changed[0] = 4;
+    writeBytes(image, changed);
+    CHECK(!cache.lookup(keyFor(image, cv::Size(7, 10), flags), detection));
+    CHECK(cache.misses() == 3 && cache.hits() == 0);
+
+    // Other entries are unaffected by the invalidation of one image
+    CHECK(cache.lookup(key, detection));
+}
+
+TEST_CASE(prefilterRejectionsAreNotCached) {
+    testing::TempDir dir;
+    std::string image = dir.file("view.png");
+    writeBytes(image, std::vector<uchar>(100, 6));
+
+    // Results of a full search do not depend on the prefilter, so they are shared with runs
+    // without it or with other thresholds
+    DetectionOptions prefiltered;
+    prefiltered.prefilter.enabled = true;
+    prefiltered.prefilter.minContrast = 40.0;
+    CHECK(detectionCacheFlags(prefiltered) == detectionCacheFlags(DetectionOptions()));
+    CornerCacheKey key = keyFor(image, cv::Size(7, 10), detectionCacheFlags(prefiltered));
+
+    ImageDetection rejected;
+    rejected.imageRead = true;
+    rejected.prefilter.rejected = true;
+    CornerCache cache;
+    cache.store(key, rejected);
+    CHECK(cache.size() == 0);
+    CHECK(!cache.dirty());
+
+    ImageDetection audited = foundDetection(70);
+    audited.prefilter.rejected = true;
+    audited.prefilter.audited = true;
+    audited.prefilter.auditFound = true;
+    cache.store(key, audited);
+    ImageDetection detection;
+    CHECK(cache.lookup(key, detection));
+    CHECK(detection.found && detection.corners == audited.corners);
+}
+
+TEST_CASE(corruptCacheFilesAreIgnored) {
+    testing::TempDir dir;
+    std::string image = dir.file("view.png");
+    writeBytes(image, std::vector<uchar>(100, 5));
+    CornerCacheKey key = keyFor(image, cv::Size(7, 10), detectionCacheFlags(DetectionOptions()));
+
+    CornerCache cache;
+    cache.store(key, foundDetection(70));
+    std::string path = dir.file("corners.cache");
+    CHECK(cache.save(path));
+    uintmax_t size = std::filesystem::file_size(path);
+
+    std::filesystem::resize_file(path, size - 8);
+    CornerCache truncated;
+    CHECK(!truncated.load(path));
+    CHECK(truncated.size() == 0);
+
+    writeBytes(path, std::vector<uchar>(static_cast<size_t>(size), 0xAB));
+    CornerCache garbage;
+    CHECK(!garbage.load(path));
+    CHECK(garbage.size() == 0);
+
+    CornerCache missing;
+    CHECK(!missing.load(dir.file("does_not_exist.cache")));
+}
+
+TEST_MAIN
@@ -0,0 +1,79 @@
+#include "testing.hpp"
+
+#include "cameracalib/cornerFile.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace cameracalib;
+
+namespace {
+
+CornerSet makeCorners(const cv::Size& board, int views, const std::string& prefix, float offset) {
+    CornerSet corners;
+    corners.imageSize = cv::Size(1280, 960);
+    corners.checkerboardSize = board;
+    for (int v = 0; v < views; v++) {
+        corners.viewNames.push_back(prefix + std::to_string(v) + ".png");
+        std::vector<cv::Point2f> points;
+        for (int i = 0; i < board.area(); i++) {
+            points.push_back(cv::Point2f(offset + 0.1f * i + v, offset + 1.0f / 3.0f * i));
+        }
+        corners.imgpoints.push_back(points);
+    }
+    return corners;
+}
+
+} // namespace
+
+TEST_CASE(cornerFileRoundTripIsExact) {
+    testing::TempDir dir;
+    CornerSet corners = makeCorners(cv::Size(7, 10), 3, "view_", 12.5f);
+    CHECK(saveCornerFile(corners, dir.file("corners.bin")));
+
+    CornerSet loaded;
+    CHECK(loadCornerFile(dir.file("corners.bin"), loaded));
+    CHECK(loaded.imageSize == corners.imageSize);
+    CHECK(loaded.checkerboardSize == corners.checkerboardSize);
+    CHECK(loaded.viewNames == corners.viewNames);
+    CHECK(loaded.imgpoints == corners.imgpoints);
+}
+
+TEST_CASE(cornerFilesMergeInOrder) {
+    testing::TempDir dir;
+    CornerSet shard0 = makeCorners(cv::Size(7, 10), 2, "a_", 1.0f);
+    CornerSet shard1 = makeCorners(cv::Size(7, 10), 3, "b_", 2.0f);
+    CHECK(saveCornerFile(shard0, dir.file("shard0.bin")));
+    CHECK(saveCornerFile(shard1, dir.file("shard1.bin")));
+
+    CornerSet merged;
+    CHECK(loadCornerFile(dir.file("shard0.bin"), merged));
+    CHECK(loadCornerFile(dir.file("shard1.bin"), merged));
+    CHECK(merged.imgpoints.size() == 5);
+    CHECK(merged.viewNames.front() == "a_0.png");
+    CHECK(merged.viewNames.back() == "b_2.png");
+    CHECK(merged.imgpoints[2] == shard1.imgpoints[0]);
+}
+
+TEST_CASE(mismatchedOrDamagedCornerFilesAreRejected) {
+    testing::TempDir dir;
+    CHECK(saveCornerFile(makeCorners(cv::Size(7, 10), 2, "a_", 1.0f), dir.file("board7x10.bin")));
+    CHECK(saveCornerFile(makeCorners(cv::Size(9, 6), 2, "b_", 1.0f), dir.file("board9x6.bin")));
+
+    CornerSet merged;
+    CHECK(loadCornerFile(dir.file("board7x10.bin"), merged));
+    CHECK(!loadCornerFile(dir.file("board9x6.bin"), merged));
+    CHECK(merged.imgpoints.size() == 2);
+
+    std::string truncated = dir.file("truncated.bin");
+    std::filesystem::copy_file(dir.file("board7x10.bin"), truncated);
+    std::filesystem::resize_file(truncated, std::filesystem::file_size(truncated) - 4);
+    CornerSet partial;
+    CHECK(!loadCornerFile(truncated, partial));
+
+    CornerSet missing;
+    CHECK(!loadCornerFile(dir.file("does_not_exist.bin"), missing));
+}
+
+TEST_MAIN
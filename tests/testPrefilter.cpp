@@ -0,0 +1,87 @@
+#include "testing.hpp"
+
+#include "cameracalib/prefilter.hpp"
+#include "cameracalib/synthetic.hpp"
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+using namespace cameracalib;
+
+namespace {
+
+const cv::Size kBoard(7, 10);
+
+cv::Mat syntheticBoardView() {
+    SyntheticOptions options;
+    options.imageSize = cv::Size(640, 480);
+    options.checkerboardSize = kBoard;
+    options.numViews = 1;
+    std::vector<SyntheticView> views;
+    CHECK(generateSyntheticPoses(options, views));
+    renderSyntheticView(options, 0, views[0]);
+    return views[0].image;
+}
+
+} // namespace
+
+TEST_CASE(featurelessImagesAreRejected) {
+    PrefilterOptions options;
+    options.enabled = true;
+
+    cv::Mat uniform(480, 640, CV_8UC1, cv::Scalar(128));
+    PrefilterScores flat = computePrefilterScores(uniform, options);
+    CHECK(flat.contrast < options.minContrast);
+    CHECK(flat.saddlePoints == 0);
+    CHECK(!prefilterAccepts(flat, kBoard, options));
+
+    // A smooth gradient has contrast but neither edges nor corners
+    cv::Mat gradient(480, 640, CV_8UC1);
+    for (int y = 0; y < gradient.rows; y++) {
+        for (int x = 0; x < gradient.cols; x++) {
+            gradient.at<uchar>(y, x) = static_cast<uchar>(x * 255 / gradient.cols);
+        }
+    }
+    PrefilterScores smooth = computePrefilterScores(gradient, options);
+    CHECK(smooth.contrast >= options.minContrast);
+    CHECK(!prefilterAccepts(smooth, kBoard, options));
+}
+
+TEST_CASE(boardViewsAreAccepted) {
+    PrefilterOptions options;
+    options.enabled = true;
+    PrefilterScores scores = computePrefilterScores(syntheticBoardView(), options);
+    CHECK(scores.contrast >= options.minContrast);
+    CHECK(scores.sharpness >= options.minSharpness);
+    CHECK(scores.saddlePoints >= options.minSaddleFraction * kBoard.area());
+    CHECK(prefilterAccepts(scores, kBoard, options));
+
+    // A board with far more inner corners than are visible is ruled out
+    CHECK(!prefilterAccepts(scores, cv::Size(40, 40), options));
+}
+
+TEST_CASE(auditSampleDependsOnWholeImage) {
+    PrefilterOptions options;
+    cv::Mat board = syntheticBoardView();
+    PrefilterScores scores = computePrefilterScores(board, options);
+    CHECK(!prefilterAuditSelects(scores, 0.0));
+    CHECK(prefilterAuditSelects(scores, 1.0));
+    CHECK(computePrefilterScores(board.clone(), options).thumbnailHash == scores.thumbnailHash);
+
+    // Images that share their top rows, like frames with a black border, are still sampled
+    // at about the requested rate
+    const int images = 200;
+    int selected = 0;
+    cv::RNG rng(7);
+    for (int i = 0; i < images; i++) {
+        cv::Mat image(480, 640, CV_8UC1, cv::Scalar(0));
+        cv::Mat bottom = image.rowRange(240, 480);
+        rng.fill(bottom, cv::RNG::UNIFORM, 0, 256);
+        if (prefilterAuditSelects(computePrefilterScores(image, options), 0.5)) {
+            selected++;
+        }
+    }
+    CHECK(selected > images / 4 && selected < 3 * images / 4);
+}
+
+TEST_MAIN
@@ -0,0 +1,153 @@
+#include "testing.hpp"
+
+#include "cameracalib/threadPool.hpp"
+#include "cameracalib/tiledRemap.hpp"
+#include "cameracalib/undistortion.hpp"
+
+#include <opencv2/core.hpp>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+using namespace cameracalib;
+
+namespace {
+
+const cv::Size kImageSize(640, 480);
+
+CalibrationResults testCalibration() {
+    CalibrationResults results;
+    results.cameraMatrix = (cv::Mat_<double>(3, 3) << 520.0, 0.0, 322.5, 0.0, 515.0, 236.0, 0.0, 0.0, 1.0);
+    results.distCoeffs = (cv::Mat_<double>(1, 5) << -0.28, 0.09, 0.0012, -0.0008, -0.01);
+    results.imageSize = kImageSize;
+    results.success = true;
+    return results;
+}
+
+cv::Mat testImage(int type) {
+    cv::Mat image(kImageSize, type);
+    cv::RNG rng(42);
+    rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+    return image;
+}
+
+// Overwrites the 32-bit field at offset of a file in place
+void patchInt32(const std::string& path, std::streamoff offset, int32_t value) {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Largest per-channel difference between two 8-bit images of the same size and type
+double maxDifference(const cv::Mat& a, const cv::Mat& b) {
+    return cv::norm(a, b, cv::NORM_INF);
+}
+
+} // namespace
+
+TEST_CASE(compactMapsStayCloseToFloatMaps) {
+    CalibrationResults results = testCalibration();
+
+    UndistortMaps floatMaps;
+    UndistortMapAccuracy floatAccuracy;
+    floatAccuracy.maxError = -1.0;
+    buildUndistortMaps(results, kImageSize, floatMaps, UndistortMapFormat::Float, &floatAccuracy);
+    CHECK(floatMaps.format() == UndistortMapFormat::Float);
+    CHECK(floatAccuracy.maxError == 0.0);
+    CHECK(measureUndistortMapAccuracy(results, floatMaps).maxError < 1e-3);
+
+    // Fixed-point positions are rounded to 1/32 pixel per axis
+    UndistortMaps fixedMaps;
+    UndistortMapAccuracy fixedAccuracy;
+    buildUndistortMaps(results, kImageSize, fixedMaps, UndistortMapFormat::Fixed, &fixedAccuracy);
+    CHECK(fixedMaps.format() == UndistortMapFormat::Fixed);
+    CHECK(fixedAccuracy.maxError <= 0.5 * std::sqrt(2.0) / 32 + 1e-3);
+    CHECK(fixedAccuracy.meanError <= fixedAccuracy.maxError);
+
+    UndistortMapAccuracy coarse, fine;
+    UndistortMaps gridMaps;
+    buildUndistortMaps(results, kImageSize, gridMaps, UndistortMapFormat::Grid, &coarse, 32);
+    CHECK(gridMaps.format() == UndistortMapFormat::Grid);
+    CHECK(gridMaps.map1.size() == undistortGridSize(kImageSize, 32));
+    buildUndistortMaps(results, kImageSize, gridMaps, UndistortMapFormat::Grid, &fine, 8);
+    CHECK(fine.maxError < 0.5);
+    CHECK(fine.maxError < coarse.maxError);
+    CHECK(fine.meanError < coarse.meanError);
+}
+
+TEST_CASE(tiledRemapMatchesOpenCVForEveryMapFormat) {
+    CalibrationResults results = testCalibration();
+    ThreadPool pool(3);
+    for (UndistortMapFormat format : {UndistortMapFormat::Float, UndistortMapFormat::Fixed, UndistortMapFormat::Grid}) {
+        UndistortMaps maps;
+        buildUndistortMaps(results, kImageSize, maps, format);
+        for (int type : {CV_8UC1, CV_8UC3}) {
+            cv::Mat src = testImage(type);
+            cv::Mat expected, tiled, tiledParallel;
+            remapImage(maps, src, expected);
+            remapTiled(maps, src, tiled);
+            remapTiled(maps, src, tiledParallel, &pool);
+
+            // Output covers the whole image, also for grid maps whose map1 is only the mesh
+            CHECK(tiled.size() == kImageSize);
+            CHECK(tiled.type() == src.type());
+            CHECK(expected.size() == kImageSize);
+            if (tiled.size() != expected.size()) {
+                continue;
+            }
+            CHECK(maxDifference(tiled, expected) <= 1.0);
+            CHECK(maxDifference(tiled, tiledParallel) == 0.0);
+        }
+    }
+}
+
+TEST_CASE(tiledRemapFallsBackForUnsupportedTypes) {
+    CalibrationResults results = testCalibration();
+    UndistortMaps maps;
+    buildUndistortMaps(results, kImageSize, maps, UndistortMapFormat::Grid);
+    cv::Mat src(kImageSize, CV_32FC1, cv::Scalar(0.5));
+    cv::Mat expected, tiled;
+    remapImage(maps, src, expected);
+    remapTiled(maps, src, tiled);
+    CHECK(tiled.size() == kImageSize);
+    CHECK(maxDifference(tiled, expected) == 0.0);
+}
+
+TEST_CASE(mapFilesRoundTripAndRejectUnknownTypes) {
+    testing::TempDir dir;
+    CalibrationResults results = testCalibration();
+    for (UndistortMapFormat format : {UndistortMapFormat::Float, UndistortMapFormat::Fixed, UndistortMapFormat::Grid}) {
+        UndistortMaps maps;
+        buildUndistortMaps(results, kImageSize, maps, format);
+        std::string path = dir.file(std::string(undistortMapFormatName(format)) + ".maps");
+        CHECK(saveUndistortMaps(maps, path));
+
+        UndistortMaps loaded;
+        CHECK(loadUndistortMaps(path, maps.fingerprint, loaded));
+        CHECK(loaded.format() == format);
+        CHECK(loaded.imageSize == kImageSize);
+        CHECK(loaded.map1.type() == maps.map1.type() && cv::norm(loaded.map1, maps.map1, cv::NORM_INF) == 0.0);
+        CHECK(loaded.map2.empty() == maps.map2.empty());
+        if (!maps.map2.empty()) {
+            CHECK(loaded.map2.type() == maps.map2.type() && cv::norm(loaded.map2, maps.map2, cv::NORM_INF) == 0.0);
+        }
+        CHECK(!loadUndistortMaps(path, maps.fingerprint + 1, loaded));
+    }
+
+    // map1Type sits after magic, version, byte order mark and the image size. A type of the
+    // same element size passes the size checks, so only the type check rejects it.
+    const std::streamoff map1TypeOffset = 24;
+    UndistortMaps maps;
+    buildUndistortMaps(results, kImageSize, maps, UndistortMapFormat::Float);
+    std::string path = dir.file("patched.maps");
+    for (int32_t type : {int32_t(CV_32SC1), int32_t(0x7fff)}) {
+        CHECK(saveUndistortMaps(maps, path));
+        patchInt32(path, map1TypeOffset, type);
+        UndistortMaps loaded;
+        CHECK(!loadUndistortMaps(path, maps.fingerprint, loaded));
+        CHECK(loaded.empty());
+    }
+}
+
+TEST_MAIN
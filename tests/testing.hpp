@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// Minimal self-registering test cases for the ctest executables in this directory. Every
+// test file defines its cases with TEST_CASE and ends with TEST_MAIN.
+namespace cameracalib {
+namespace testing {
+
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<TestCase>& testCases() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+inline int& failureCount() {
+    static int failures = 0;
+    return failures;
+}
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*run)()) { testCases().push_back({name, run}); }
+};
+
+inline void reportFailure(const char* file, int line, const std::string& message) {
+    std::cerr << file << ":" << line << ": " << message << std::endl;
+    failureCount()++;
+}
+
+inline int runTests() {
+    int failedCases = 0;
+    for (const TestCase& test : testCases()) {
+        int failuresBefore = failureCount();
+        try {
+            test.run();
+        } catch (const std::exception& e) {
+            reportFailure(test.name, 0, std::string("unexpected exception: ") + e.what());
+        }
+        bool passed = failureCount() == failuresBefore;
+        std::cout << (passed ? "[  OK  ] " : "[FAILED] ") << test.name << std::endl;
+        if (!passed) {
+            failedCases++;
+        }
+    }
+    std::cout << testCases().size() - failedCases << " of " << testCases().size() << " test case(s) passed" << std::endl;
+    return failedCases == 0 ? 0 : 1;
+}
+
+// Fresh directory below the system temp directory, removed with everything in it on destruction
+class TempDir {
+public:
+    TempDir() {
+        std::random_device random;
+        path_ = std::filesystem::temp_directory_path() / ("cameracalib_test_" + std::to_string(random()));
+        std::filesystem::create_directories(path_);
+    }
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+    ~TempDir() {
+        std::error_code error;
+        std::filesystem::remove_all(path_, error);
+    }
+
+    std::string file(const std::string& name) const { return (path_ / name).string(); }
+
+private:
+    std::filesystem::path path_;
+};
+
+} // namespace testing
+} // namespace cameracalib
+
+#define TEST_CASE(name)                                                                   \
+    static void name();                                                                   \
+    static cameracalib::testing::TestRegistrar name##Registrar(#name, name);              \
+    static void name()
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            cameracalib::testing::reportFailure(__FILE__, __LINE__, "CHECK(" #condition ") failed"); \
+        }                                                                                 \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                           \
+    do {                                                                                  \
+        double checkActual = (actual);                                                    \
+        double checkExpected = (expected);                                                \
+        if (!(std::abs(checkActual - checkExpected) <= (tolerance))) {                    \
+            cameracalib::testing::reportFailure(__FILE__, __LINE__,                       \
+                "CHECK_NEAR(" #actual ", " #expected ") failed: " + std::to_string(checkActual) + \
+                " vs " + std::to_string(checkExpected));                                  \
+        }                                                                                 \
+    } while (0)
+
+#define TEST_MAIN                                                                         \
+    int main() { return cameracalib::testing::runTests(); }